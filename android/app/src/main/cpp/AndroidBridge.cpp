@@ -18,6 +18,7 @@
 #include "KeyEvent.h"
 #include "KeyboardState.h"
 #include "MessageSender.h"
+#include "TlsContext.h"
 
 #define TAG "NVDARemote/Bridge"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO,  TAG, __VA_ARGS__)
@@ -84,13 +85,16 @@ static void NotifyConnectionState(int profileIndex, bool connected) {
 static void SyncConnectedProfiles() {
     std::vector<int> indices;
     std::vector<std::string> names;
+    std::vector<int> broadcast;
     for (int i = 0; i < static_cast<int>(g_config.profiles.size()); i++) {
         if (i < static_cast<int>(g_managers.size()) && g_managers[i] && g_managers[i]->IsConnected()) {
             indices.push_back(i);
             names.push_back(g_config.profiles[i].name);
+            if (g_config.profiles[i].broadcast) broadcast.push_back(i);
         }
     }
     AppState::SetConnectedProfiles(indices, names);
+    AppState::SetBroadcastProfiles(broadcast.empty() ? indices : broadcast);
 }
 
 static void ApplyShortcutsFromConfig() {
@@ -154,6 +158,12 @@ Java_org_gozaltech_nvdaremotecompanion_android_NativeBridge_nativeInit(
         g_config = ConfigFile::Load(g_configPath);
     }
 
+    CipherPreference ciphers = CipherPreference::Auto;
+    if (g_config.cipherPreference && !ParseCipherPreference(*g_config.cipherPreference, ciphers)) {
+        LOGI("Unknown cipher_preference '%s', using auto", g_config.cipherPreference->c_str());
+    }
+    TlsContext::SetCipherPreference(ciphers);
+
     {
         std::lock_guard<std::mutex> lock(g_managersMutex);
         g_managers.resize(g_config.profiles.size());
@@ -454,6 +464,13 @@ Java_org_gozaltech_nvdaremotecompanion_android_NativeBridge_nativeProcessModifie
         return JNI_TRUE;
     }
 
+    if (KeyboardState::CheckBroadcastShortcut(vk)) {
+        KeyboardState::ResetModifiers();
+        AppState::ToggleBroadcast();
+        NotifyForwardingState(AppState::IsSendingKeys());
+        return JNI_TRUE;
+    }
+
     if (AppState::IsSendingKeys()) return JNI_FALSE;
 
     if (KeyboardState::CheckCycleShortcut(vk)) {
@@ -536,7 +553,7 @@ Java_org_gozaltech_nvdaremotecompanion_android_NativeBridge_nativeSendClipboardT
     std::string clipText = JniToString(env, text);
     if (clipText.empty()) return;
 
-    MessageSender::SendClipboardText(clipText);
-    LOGI("Clipboard text sent from Android");
+    auto result = MessageSender::SendClipboardText(clipText);
+    LOGI("%s", MessageSender::DescribeClipboardResult(result));
 }
 }
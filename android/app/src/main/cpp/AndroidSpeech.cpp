@@ -1,5 +1,6 @@
 #include "AndroidSpeech.h"
 #include "Speech.h"
+#include "SpeechQueue.h"
 #include <android/log.h>
 #include <string>
 
@@ -43,9 +44,11 @@ void AndroidSpeech::Initialize(JNIEnv* env, jobject ttsManagerRef) {
     }
 
     Speech::Initialize();
+    SpeechQueue::Start();
 }
 
 void AndroidSpeech::Cleanup(JNIEnv* env) {
+    SpeechQueue::Shutdown();
     if (s_ttsRef) {
         env->DeleteGlobalRef(s_ttsRef);
         s_ttsRef = nullptr;
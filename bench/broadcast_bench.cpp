@@ -0,0 +1,90 @@
+// Measures broadcast key fan-out: key events go through
+// MessageSender::SendKeyEvent to every profile in the broadcast group, and
+// the clock stops when a loopback relay has received all of them:
+//
+//   broadcast_bench [--events N]
+//
+// Runs with 10 and 50 targets, then with 10 targets plus one peer that
+// reads slowly, which should not change the rate the others see.
+#include "AppState.h"
+#include "ConnectionManager.h"
+#include "MessageSender.h"
+#include "TestRelay.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // Below the point where the send queue starts collapsing key events, so
+    // every event is delivered.
+    constexpr size_t WINDOW = 64;
+
+    void Run(int targets, bool slowPeer, int events) {
+        TestRelay relay, slowRelay;
+        slowRelay.SetReadLimit(256);
+
+        std::vector<std::unique_ptr<ConnectionManager>> managers;
+        std::vector<int> group;
+        for (int i = 0; i < targets + (slowPeer ? 1 : 0); ++i) {
+            auto manager = std::make_unique<ConnectionManager>();
+            int port = i < targets ? relay.Port() : slowRelay.Port();
+            if (!manager->EstablishConnection("127.0.0.1", port, "broadcast_bench")) {
+                std::printf("  target %d failed to connect\n", i + 1);
+                ConnectionManager::ShutdownAll(std::move(managers), std::chrono::seconds(5));
+                return;
+            }
+            MessageSender::SetNetworkClient(i, manager->GetClient());
+            group.push_back(i);
+            managers.push_back(std::move(manager));
+        }
+        AppState::SetBroadcastProfiles(group);
+        AppState::ToggleBroadcast();
+
+        uint64_t expected = relay.LinesReceived() + static_cast<uint64_t>(events) * targets;
+        uint64_t slowBefore = slowRelay.LinesReceived();
+        auto start = Clock::now();
+        for (int e = 0; e < events; ++e) {
+            if (e % 32 == 0) {
+                for (int i = 0; i < targets; ++i) {
+                    auto client = managers[i]->GetClient();
+                    while (client->GetSendQueueStats().depth > WINDOW) std::this_thread::yield();
+                }
+            }
+            MessageSender::SendKeyEvent(KeyEvent(0x41 + (e / 2) % 26, e % 2 == 0, 0));
+        }
+        bool complete = WaitFor([&] { return relay.LinesReceived() >= expected; }, std::chrono::seconds(30));
+        double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+        std::printf("  %2d targets%s: %8.0f key events/s to each%s", targets, slowPeer ? " + slow peer" : "",
+                    events / elapsed, complete ? "" : " (incomplete)");
+        if (slowPeer) {
+            std::printf(", slow peer received %llu of %d",
+                        static_cast<unsigned long long>(slowRelay.LinesReceived() - slowBefore), events);
+        }
+        std::printf("\n");
+
+        AppState::SetBroadcastProfiles({});
+        for (int index : group) MessageSender::SetNetworkClient(index, nullptr);
+        ConnectionManager::ShutdownAll(std::move(managers), std::chrono::seconds(5));
+    }
+}
+
+int main(int argc, char** argv) {
+    int events = 20000;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--events") == 0 && i + 1 < argc) events = std::atoi(argv[++i]);
+    }
+
+    std::printf("Broadcast of %d key events:\n", events);
+    Run(10, false, events);
+    Run(50, false, events);
+    Run(10, true, events);
+    return 0;
+}
@@ -0,0 +1,118 @@
+// Times a connect up to the relay's channel_joined reply, once with a full
+// handshake and once resuming the previous session with the join sent as
+// early data, as a profile with early_data does:
+//
+//   connect_bench [host [port]] [--connects N] [--rtt MS[,MS...]]
+//
+// Without a host it runs against a loopback TestRelay that delays each
+// direction by half the round trip time, once for each --rtt (0, 20, 50
+// and 100 ms by default), so the round trips resumption saves show up
+// next to the handshake cost. With a host the link's own latency applies.
+#include "NetworkClient.h"
+#include "SSLClient.h"
+#include "TestRelay.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // Reads until a whole line has arrived. Ticket arrivals also come back
+    // as "no data yet" and are saved by the client.
+    bool AwaitReply(SSLClient& client, Clock::time_point deadline) {
+        char buffer[4096];
+        while (Clock::now() < deadline) {
+            int ret = client.Receive(buffer, sizeof(buffer));
+            if (ret > 0 && std::memchr(buffer, '\n', static_cast<size_t>(ret))) return true;
+            if (ret == -1) return false;
+            if (ret <= 0) std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        return false;
+    }
+
+    void Run(const char* label, const std::string& host, int port, int count, bool resume) {
+        std::string opening = NetworkClient::ProtocolVersionMessage().dump() + '\n' +
+                              NetworkClient::JoinChannelMessage("connect_bench").dump() + '\n';
+        // One client throughout, so a resumed run always has the ticket the
+        // previous connect left behind.
+        SSLClient client;
+        client.SetResumption(resume);
+        client.SetTls13(resume);
+        if (resume) {
+            if (!client.Connect(host, port, {}, nullptr, opening) ||
+                !AwaitReply(client, Clock::now() + std::chrono::seconds(5))) {
+                std::printf("  %s: warm-up connect failed\n", label);
+                return;
+            }
+            client.Disconnect();
+        }
+
+        std::vector<double> samples;
+        TlsConnectionInfo info;
+        for (int i = 0; i < count; ++i) {
+            auto start = Clock::now();
+            if (!client.Connect(host, port, {}, nullptr, opening) ||
+                !AwaitReply(client, start + std::chrono::seconds(5))) {
+                std::printf("  %s: connect %d failed\n", label, i + 1);
+                client.Disconnect();
+                continue;
+            }
+            samples.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+            info = client.GetConnectionInfo();
+            client.Disconnect();
+        }
+        if (samples.empty()) return;
+        std::sort(samples.begin(), samples.end());
+        std::printf("    %-8s %3zu connects: min %6.2f ms, median %6.2f ms, max %6.2f ms  (%s)\n", label,
+                    samples.size(), samples.front(), samples[samples.size() / 2], samples.back(), info.version);
+    }
+}
+
+int main(int argc, char** argv) {
+    int connects = 20;
+    std::vector<int> rtts = {0, 20, 50, 100};
+    std::string host;
+    int port = Config::DEFAULT_PORT;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--connects") == 0 && i + 1 < argc) {
+            connects = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--rtt") == 0 && i + 1 < argc) {
+            rtts.clear();
+            std::istringstream list(argv[++i]);
+            std::string rtt;
+            while (std::getline(list, rtt, ',')) rtts.push_back(std::atoi(rtt.c_str()));
+        } else if (host.empty()) {
+            host = argv[i];
+        } else {
+            port = std::atoi(argv[i]);
+        }
+    }
+
+    if (!host.empty()) {
+        std::printf("Connect to channel_joined, %s:%d:\n", host.c_str(), port);
+        Run("full", host, port, connects, false);
+        Run("resumed", host, port, connects, true);
+        return 0;
+    }
+
+    TestRelay relay;
+    if (!relay.Port()) {
+        std::printf("Could not start the loopback relay\n");
+        return 1;
+    }
+    std::printf("Connect to channel_joined, loopback relay:\n");
+    for (int rtt : rtts) {
+        relay.SetDelay(std::chrono::milliseconds(rtt / 2));
+        std::printf("  %d ms round trip:\n", rtt);
+        Run("full", "127.0.0.1", relay.Port(), connects, false);
+        Run("resumed", "127.0.0.1", relay.Port(), connects, true);
+    }
+    return 0;
+}
@@ -0,0 +1,210 @@
+// Measures the heap each relay connection costs, for an ordinary profile
+// (TLS 1.2) and for an early_data profile (TLS 1.3), then the resident
+// memory per connected profile at 1, 10 and 50 profiles:
+//
+//   memory_bench [host [port]] [--connections N]
+//
+// Without a host it forks a loopback TestRelay, so the relay's own buffers
+// are not counted. Build with -DNVDAREMOTE_TLS_LOW_MEMORY=ON to see what the
+// small records save. Heap figures need glibc or Android; resident memory
+// is read on Linux, Android and Windows.
+#include "ConnectionManager.h"
+#include "NetworkClient.h"
+#include "SSLClient.h"
+#include "TestRelay.h"
+#include "TlsContext.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#if defined(__GLIBC__) || defined(__ANDROID__)
+#include <malloc.h>
+#endif
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <csignal>
+#include <fstream>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // Bytes currently allocated, or -1 where the C library cannot say.
+    long long HeapInUse() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+        return static_cast<long long>(mallinfo2().uordblks);
+#elif defined(__GLIBC__) || defined(__ANDROID__)
+        return static_cast<long long>(mallinfo().uordblks);
+#else
+        return -1;
+#endif
+    }
+
+    // Resident set size in bytes, or -1 where it cannot be read.
+    long long ResidentMemory() {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters;
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return -1;
+        return static_cast<long long>(counters.WorkingSetSize);
+#else
+        std::ifstream statm("/proc/self/statm");
+        long long size = 0, resident = 0;
+        if (!(statm >> size >> resident)) return -1;
+        return resident * sysconf(_SC_PAGESIZE);
+#endif
+    }
+
+    // Waits for the join reply, which also lets TLS 1.3 tickets arrive and
+    // be saved, as they would be on a live connection.
+    bool AwaitReply(SSLClient& client) {
+        char buffer[4096];
+        auto deadline = Clock::now() + std::chrono::seconds(5);
+        while (Clock::now() < deadline) {
+            int ret = client.Receive(buffer, sizeof(buffer));
+            if (ret > 0 && std::memchr(buffer, '\n', static_cast<size_t>(ret))) return true;
+            if (ret == -1) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return false;
+    }
+
+    void Run(const char* label, const std::string& host, int port, int count, bool earlyData) {
+        std::string opening = NetworkClient::ProtocolVersionMessage().dump() + '\n' +
+                              NetworkClient::JoinChannelMessage("memory_bench").dump() + '\n';
+        auto connect = [&](SSLClient& client) {
+            client.SetResumption(earlyData);
+            client.SetTls13(earlyData);
+            return client.Connect(host, port, {}, nullptr, opening) && AwaitReply(client);
+        };
+
+        // The first connect builds the shared TLS config and fills the DNS
+        // cache; neither is a per-connection cost.
+        {
+            SSLClient warmUp;
+            if (!connect(warmUp)) {
+                std::printf("  %s: connect failed\n", label);
+                return;
+            }
+        }
+
+        long long before = HeapInUse();
+        std::vector<std::unique_ptr<SSLClient>> clients;
+        TlsConnectionInfo info;
+        for (int i = 0; i < count; ++i) {
+            auto client = std::make_unique<SSLClient>();
+            if (!connect(*client)) {
+                std::printf("  %s: connect %d failed\n", label, i + 1);
+                continue;
+            }
+            info = client->GetConnectionInfo();
+            clients.push_back(std::move(client));
+        }
+        long long after = HeapInUse();
+        if (clients.empty()) return;
+        if (before < 0) {
+            std::printf("  %-10s %3zu connections  (heap statistics unavailable)\n", label, clients.size());
+            return;
+        }
+        std::printf("  %-10s %3zu connections: %7.1f KiB each  (%s, records in %d out %d)\n", label,
+                    clients.size(), (after - before) / 1024.0 / clients.size(), info.version,
+                    info.maxInRecord, info.maxOutRecord);
+    }
+
+    // Profiles are added in steps and never removed, so each figure is
+    // measured from the same starting point and freed memory is not reused.
+    void RunProfiles(const std::string& host, int port) {
+        const int steps[] = {1, 10, 50};
+        long long before = ResidentMemory();
+        if (before < 0) {
+            std::printf("  resident memory unavailable\n");
+            return;
+        }
+        std::vector<std::unique_ptr<ConnectionManager>> managers;
+        for (int target : steps) {
+            while (static_cast<int>(managers.size()) < target) {
+                auto manager = std::make_unique<ConnectionManager>();
+                if (!manager->EstablishConnection(host, port, "memory_bench")) {
+                    std::printf("  profile %zu failed to connect\n", managers.size() + 1);
+                    ConnectionManager::ShutdownAll(std::move(managers), std::chrono::seconds(5));
+                    return;
+                }
+                managers.push_back(std::move(manager));
+            }
+            std::printf("  %3d profiles: %7.1f KiB resident each\n", target,
+                        (ResidentMemory() - before) / 1024.0 / target);
+        }
+        ConnectionManager::ShutdownAll(std::move(managers), std::chrono::seconds(5));
+    }
+}
+
+int main(int argc, char** argv) {
+    int connections = 10;
+    std::string host;
+    int port = Config::DEFAULT_PORT;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--connections") == 0 && i + 1 < argc) {
+            connections = std::atoi(argv[++i]);
+        } else if (host.empty()) {
+            host = argv[i];
+        } else {
+            port = std::atoi(argv[i]);
+        }
+    }
+
+#ifndef _WIN32
+    pid_t relayPid = -1;
+    if (host.empty()) {
+        int pipeFds[2];
+        if (pipe(pipeFds) != 0) return 1;
+        relayPid = fork();
+        if (relayPid == 0) {
+            close(pipeFds[0]);
+            TestRelay relay;
+            int relayPort = relay.Port();
+            if (write(pipeFds[1], &relayPort, sizeof(relayPort)) != sizeof(relayPort)) _exit(1);
+            close(pipeFds[1]);
+            while (true) pause();
+        }
+        close(pipeFds[1]);
+        int relayPort = 0;
+        if (relayPid < 0 || read(pipeFds[0], &relayPort, sizeof(relayPort)) != sizeof(relayPort) || !relayPort) {
+            std::printf("Could not start the loopback relay\n");
+            return 1;
+        }
+        close(pipeFds[0]);
+        host = "127.0.0.1";
+        port = relayPort;
+    }
+#else
+    if (host.empty()) {
+        std::printf("usage: memory_bench host [port] [--connections N]\n");
+        return 1;
+    }
+#endif
+
+#ifdef NVDAREMOTE_TLS_LOW_MEMORY
+    std::printf("Heap per connection to %s:%d, low-memory TLS build:\n", host.c_str(), port);
+#else
+    std::printf("Heap per connection to %s:%d:\n", host.c_str(), port);
+#endif
+    Run("TLS 1.2", host, port, connections, false);
+    Run("early_data", host, port, connections, true);
+    std::printf("Resident memory per connected profile:\n");
+    RunProfiles(host, port);
+
+#ifndef _WIN32
+    if (relayPid > 0) {
+        kill(relayPid, SIGKILL);
+        waitpid(relayPid, nullptr, 0);
+    }
+#endif
+    return 0;
+}
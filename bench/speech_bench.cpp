@@ -0,0 +1,81 @@
+// Measures how long a say-all style speak message takes to become one
+// utterance, for the sequence lengths a long document produces:
+//
+//   speech_bench [-seconds=N]
+//
+// "copy" is the old join, which copied each item out and appended it with
+// a temporary; "join" is ConnectionManager::JoinSpeechSequence; "message"
+// is the whole speak handler, parse included, with speech muted.
+#include "ConnectionManager.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    const int SEQUENCE_LENGTHS[] = {10, 500, 5000};
+
+    std::string CopyJoin(const json& sequence) {
+        std::string speechText;
+        for (const auto& item : sequence) {
+            if (item.is_string()) {
+                auto text = item.get<std::string>();
+                if (!text.empty()) speechText += text + " ";
+            }
+        }
+        if (!speechText.empty()) speechText.pop_back();
+        return speechText;
+    }
+
+    // One line of a document per item, with the command objects NVDA mixes in.
+    json SayAllMessage(int items) {
+        json sequence = json::array();
+        for (int i = 0; i < items; i++) {
+            if (i % 20 == 0) sequence.push_back({{"type", "PitchCommand"}, {"offset", 10}});
+            sequence.push_back("Line " + std::to_string(i) + " of the document being read aloud by say all.");
+        }
+        return {{"type", "speak"}, {"sequence", sequence}, {"priority", 0}};
+    }
+
+    void Measure(const char* label, int items, double seconds, const std::function<size_t()>& run) {
+        long long calls = 0;
+        size_t sink = 0;
+        auto start = Clock::now();
+        auto end = start + std::chrono::duration<double>(seconds);
+        while (Clock::now() < end) {
+            sink += run();
+            calls++;
+        }
+        double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        std::printf("  %-8s %5d items: %10.2f us/message  (%zu)\n", label, items, elapsed * 1e6 / calls,
+                    sink / static_cast<size_t>(calls));
+    }
+}
+
+int main(int argc, char** argv) {
+    double seconds = 0.5;
+    for (int i = 1; i < argc; i++) {
+        if (std::strncmp(argv[i], "-seconds=", 9) == 0) seconds = std::atof(argv[i] + 9);
+    }
+
+    ConnectionManager manager;
+    manager.SetSpeechEnabled(false);
+
+    std::printf("Speech sequence joining:\n");
+    for (int items : SEQUENCE_LENGTHS) {
+        json message = SayAllMessage(items);
+        const json& sequence = message["sequence"];
+        std::string text = message.dump();
+        Measure("copy", items, seconds, [&] { return CopyJoin(sequence).size(); });
+        Measure("join", items, seconds, [&] { return ConnectionManager::JoinSpeechSequence(sequence).size(); });
+        Measure("message", items, seconds, [&] {
+            manager.HandleIncomingMessage(text);
+            return text.size();
+        });
+    }
+    return 0;
+}
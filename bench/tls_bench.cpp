@@ -0,0 +1,157 @@
+// Measures the AEADs a relay connection can negotiate, at the record sizes
+// the protocol produces, and optionally times full handshakes to a relay:
+//
+//   tls_bench [-seconds=N] [host [port]] [--handshakes N]
+//
+// Run it on the target hardware to check what cipher_preference "auto"
+// picks there, and whether the choice is right.
+#include "SSLClient.h"
+#include "TlsContext.h"
+#include <mbedtls/chachapoly.h>
+#include <mbedtls/gcm.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/ssl_ciphersuites.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // A key press, a typical speech line and a full TLS record.
+    const size_t RECORD_SIZES[] = {64, 1024, 16384};
+
+    struct Aead {
+        const char* name;
+        std::function<void(size_t, const unsigned char*, unsigned char*, unsigned char*)> encrypt;
+        std::function<void(size_t, const unsigned char*, unsigned char*, const unsigned char*)> decrypt;
+    };
+
+    void Measure(const Aead& aead, size_t size, double seconds) {
+        std::vector<unsigned char> plain(size, 0x5a), sealed(size), opened(size);
+        unsigned char tag[16];
+        auto run = [&](bool decrypt) {
+            long long records = 0;
+            auto start = Clock::now();
+            auto end = start + std::chrono::duration<double>(seconds);
+            while (Clock::now() < end) {
+                for (int i = 0; i < 64; ++i) {
+                    if (decrypt) aead.decrypt(size, sealed.data(), opened.data(), tag);
+                    else aead.encrypt(size, plain.data(), sealed.data(), tag);
+                }
+                records += 64;
+            }
+            double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+            std::printf("  %-18s %-7s %6zu B  %9.0f ns/record  %8.1f MB/s\n", aead.name,
+                        decrypt ? "decrypt" : "encrypt", size, elapsed * 1e9 / records,
+                        records * size / elapsed / 1e6);
+        };
+        run(false);
+        run(true);
+    }
+
+    void RunCiphers(double seconds) {
+        const unsigned char key[32] = {1, 2, 3, 4, 5, 6, 7, 8};
+        const unsigned char iv[12] = {9, 8, 7, 6, 5, 4, 3, 2, 1};
+        const unsigned char aad[13] = {0x17, 0x03, 0x03};
+
+        mbedtls_gcm_context gcm128, gcm256;
+        mbedtls_gcm_init(&gcm128);
+        mbedtls_gcm_init(&gcm256);
+        mbedtls_gcm_setkey(&gcm128, MBEDTLS_CIPHER_ID_AES, key, 128);
+        mbedtls_gcm_setkey(&gcm256, MBEDTLS_CIPHER_ID_AES, key, 256);
+        mbedtls_chachapoly_context chacha;
+        mbedtls_chachapoly_init(&chacha);
+        mbedtls_chachapoly_setkey(&chacha, key);
+
+        auto gcm = [&](const char* name, mbedtls_gcm_context* ctx) {
+            return Aead{name,
+                [&, ctx](size_t n, const unsigned char* in, unsigned char* out, unsigned char* tag) {
+                    mbedtls_gcm_crypt_and_tag(ctx, MBEDTLS_GCM_ENCRYPT, n, iv, sizeof(iv), aad, sizeof(aad),
+                                              in, out, 16, tag);
+                },
+                [&, ctx](size_t n, const unsigned char* in, unsigned char* out, const unsigned char* tag) {
+                    mbedtls_gcm_auth_decrypt(ctx, n, iv, sizeof(iv), aad, sizeof(aad), tag, 16, in, out);
+                }};
+        };
+        const Aead aeads[] = {
+            gcm("AES-128-GCM", &gcm128),
+            gcm("AES-256-GCM", &gcm256),
+            Aead{"ChaCha20-Poly1305",
+                [&](size_t n, const unsigned char* in, unsigned char* out, unsigned char* tag) {
+                    mbedtls_chachapoly_encrypt_and_tag(&chacha, n, iv, aad, sizeof(aad), in, out, tag);
+                },
+                [&](size_t n, const unsigned char* in, unsigned char* out, const unsigned char* tag) {
+                    mbedtls_chachapoly_auth_decrypt(&chacha, n, iv, aad, sizeof(aad), tag, in, out);
+                }},
+        };
+        for (const auto& aead : aeads) {
+            for (size_t size : RECORD_SIZES) Measure(aead, size, seconds);
+        }
+
+        mbedtls_chachapoly_free(&chacha);
+        mbedtls_gcm_free(&gcm256);
+        mbedtls_gcm_free(&gcm128);
+    }
+
+    // Each sample is a fresh SSLClient without resumption, so it pays for
+    // DNS (cached after the first), TCP and a full handshake.
+    void RunHandshakes(const std::string& host, int port, int count) {
+        std::vector<double> samples;
+        TlsConnectionInfo info;
+        for (int i = 0; i < count; ++i) {
+            SSLClient client;
+            auto start = Clock::now();
+            if (!client.Connect(host, port)) {
+                std::printf("  handshake %d failed\n", i + 1);
+                continue;
+            }
+            samples.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+            info = client.GetConnectionInfo();
+            client.Disconnect();
+        }
+        if (samples.empty()) return;
+        std::sort(samples.begin(), samples.end());
+        std::printf("  %zu handshakes to %s:%d: min %.1f ms, median %.1f ms, max %.1f ms\n", samples.size(),
+                    host.c_str(), port, samples.front(), samples[samples.size() / 2], samples.back());
+        std::printf("  negotiated %s %s\n", info.version, info.ciphersuite);
+    }
+}
+
+int main(int argc, char** argv) {
+    double seconds = 0.5;
+    int handshakes = 10;
+    std::string host;
+    int port = Config::DEFAULT_PORT;
+    for (int i = 1; i < argc; i++) {
+        if (std::strncmp(argv[i], "-seconds=", 9) == 0) {
+            seconds = std::atof(argv[i] + 9);
+        } else if (std::strcmp(argv[i], "--handshakes") == 0 && i + 1 < argc) {
+            handshakes = std::atoi(argv[++i]);
+        } else if (host.empty()) {
+            host = argv[i];
+        } else {
+            port = std::atoi(argv[i]);
+        }
+    }
+
+    std::printf("AES acceleration: %s\n", TlsContext::HasAesAcceleration() ? "available" : "unavailable");
+    std::printf("Offered ciphersuites (%s):\n", DescribeCipherPreference(CipherPreference::Auto));
+    for (int id : TlsContext::OrderCiphersuites(CipherPreference::Auto)) {
+        if (id != 0) std::printf("  %s\n", mbedtls_ssl_get_ciphersuite_name(id));
+    }
+
+    std::printf("AEAD throughput:\n");
+    RunCiphers(seconds);
+
+    if (!host.empty()) {
+        std::printf("Handshakes:\n");
+        RunHandshakes(host, port, handshakes);
+    }
+    return 0;
+}
@@ -0,0 +1,98 @@
+// Measures tone synthesis on the mixer thread, writing to a NullSink so
+// the figures are not paced by a sound device:
+//
+//   tone_bench [--tones N] [--length MS]
+//
+// "serial" plays each tone to the end before the next, "overlap" plays
+// eight at once, and "burst" fires tones back to back the way NVDA sends
+// progress beeps, where each new tone cuts the previous one short.
+#include "AudioMixer.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    constexpr int OVERLAP = 8;
+
+    size_t BlockFrames(int lengthMs) {
+        size_t frames = static_cast<size_t>(lengthMs) * AudioMixer::SAMPLE_RATE / 1000;
+        return (frames + AudioMixer::BLOCK_FRAMES - 1) / AudioMixer::BLOCK_FRAMES * AudioMixer::BLOCK_FRAMES;
+    }
+
+    void WaitForFrames(const NullSink& sink, size_t frames) {
+        while (sink.FramesWritten() < frames) std::this_thread::yield();
+    }
+
+    // Returns once the mixer has written nothing for a few blocks' time.
+    void WaitUntilIdle(const NullSink& sink) {
+        size_t last = sink.FramesWritten();
+        while (true) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            size_t now = sink.FramesWritten();
+            if (now == last) return;
+            last = now;
+        }
+    }
+
+    void Report(const char* label, int tones, size_t frames, Clock::time_point start) {
+        double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        double audioSeconds = static_cast<double>(frames) / AudioMixer::SAMPLE_RATE;
+        std::printf("  %-8s %6d tones: %9.0f tones/s, %6.1fx realtime, %7.2f s of audio\n", label, tones,
+                    tones / elapsed, audioSeconds / elapsed, audioSeconds);
+    }
+}
+
+int main(int argc, char** argv) {
+    int tones = 2000;
+    int lengthMs = 50;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--tones") == 0 && i + 1 < argc) {
+            tones = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--length") == 0 && i + 1 < argc) {
+            lengthMs = std::atoi(argv[++i]);
+        }
+    }
+    const size_t toneFrames = BlockFrames(lengthMs);
+
+    std::printf("Tones of %d ms on a null sink:\n", lengthMs);
+    {
+        auto sink = std::make_unique<NullSink>();
+        const NullSink& output = *sink;
+        AudioMixer mixer(std::move(sink));
+        auto start = Clock::now();
+        for (int i = 0; i < tones; ++i) {
+            mixer.PlayTone(200 + i % 1000, lengthMs);
+            WaitForFrames(output, toneFrames * (i + 1));
+        }
+        Report("serial", tones, output.FramesWritten(), start);
+    }
+    {
+        auto sink = std::make_unique<NullSink>();
+        const NullSink& output = *sink;
+        AudioMixer mixer(std::move(sink));
+        auto start = Clock::now();
+        int rounds = tones / OVERLAP;
+        for (int i = 0; i < rounds; ++i) {
+            for (int j = 0; j < OVERLAP; ++j) mixer.PlayTone(200 + j * 150, lengthMs, ToneWave::Sine, true);
+            WaitForFrames(output, toneFrames * (i + 1));
+        }
+        Report("overlap", rounds * OVERLAP, output.FramesWritten(), start);
+    }
+    {
+        auto sink = std::make_unique<NullSink>();
+        const NullSink& output = *sink;
+        AudioMixer mixer(std::move(sink));
+        auto start = Clock::now();
+        for (int i = 0; i < tones; ++i) mixer.PlayTone(200 + i % 1000, lengthMs, ToneWave::Square);
+        WaitUntilIdle(output);
+        Report("burst", tones, output.FramesWritten(), start);
+        std::printf("  burst wrote %.1f%% of the audio it would have without cancellation\n",
+                    100.0 * output.FramesWritten() / (toneFrames * tones));
+    }
+    return 0;
+}
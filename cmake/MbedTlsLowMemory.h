@@ -0,0 +1,7 @@
+/* Used instead of MbedTlsUserConfig.h when the build enables
+ * NVDAREMOTE_TLS_LOW_MEMORY. Record buffers are allocated at full size for
+ * the handshake and shrink to the negotiated max_fragment_length after it. */
+#include "MbedTlsUserConfig.h"
+
+#define MBEDTLS_SSL_MAX_FRAGMENT_LENGTH
+#define MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH
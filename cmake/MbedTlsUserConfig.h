@@ -0,0 +1,11 @@
+/* Appended to the Mbed TLS default configuration. Early data lets a resumed
+ * TLS 1.3 session carry the protocol_version and join lines in its first
+ * flight, for profiles that set early_data. */
+#define MBEDTLS_SSL_EARLY_DATA
+
+/* AES-NI and the Armv8 AES instructions are already used when the CPU has
+ * them. SHA-256 needs opting in; it backs the handshake hashes and the
+ * TLS 1.3 key schedule. */
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define MBEDTLS_SHA256_USE_ARMV8_A_CRYPTO_IF_PRESENT
+#endif
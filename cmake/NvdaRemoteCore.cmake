@@ -0,0 +1,52 @@
+# Portable core of the client: networking, protocol dispatch, routing,
+# config and keyboard state. Shared by the desktop build and the Android
+# library. Speech, Audio and Clipboard are declared by the core but
+# implemented by a platform backend target that the final binary links.
+
+set(NVDAREMOTE_CORE_SOURCES
+    NetworkClient.cpp
+    SSLClient.cpp
+    TlsContext.cpp
+    TcpConnector.cpp
+    DnsCache.cpp
+    ConnectionManager.cpp
+    ConfigFile.cpp
+    KeyboardState.cpp
+    AppState.cpp
+    MessageSender.cpp
+    RoutingState.cpp
+    SendQueue.cpp
+    ReceiveFramer.cpp
+    SpeechQueue.cpp
+    Debug.cpp
+)
+
+# nvdaremote_add_core(<name>) creates a static library from the core
+# sources. The fuzz build calls it again to get an instrumented copy.
+function(nvdaremote_add_core name)
+    set(src_dir ${CMAKE_CURRENT_FUNCTION_LIST_DIR}/../src)
+    set(sources ${NVDAREMOTE_CORE_SOURCES})
+    list(TRANSFORM sources PREPEND ${src_dir}/)
+
+    add_library(${name} STATIC ${sources})
+    set_target_properties(${name} PROPERTIES POSITION_INDEPENDENT_CODE ON)
+    target_include_directories(${name} PUBLIC ${src_dir})
+    target_link_libraries(${name} PUBLIC mbedtls mbedcrypto mbedx509 nlohmann_json::nlohmann_json)
+    target_compile_definitions(${name} PUBLIC
+        NLOHMANN_JSON_DISABLE_ENUM_SERIALIZATION
+        JSON_DISABLE_ENUM_SERIALIZATION
+        JSON_USE_IMPLICIT_CONVERSIONS=0
+        JSON_DIAGNOSTICS=0
+    )
+
+    if(NVDAREMOTE_TLS_LOW_MEMORY)
+        target_compile_definitions(${name} PUBLIC NVDAREMOTE_TLS_LOW_MEMORY)
+    endif()
+
+    if(WIN32)
+        target_compile_definitions(${name} PUBLIC WIN32_LEAN_AND_MEAN NOMINMAX _WIN32_WINNT=0x0601)
+        target_link_libraries(${name} PUBLIC ws2_32)
+    elseif(ANDROID)
+        target_link_libraries(${name} PUBLIC log)
+    endif()
+endfunction()
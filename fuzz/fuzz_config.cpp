@@ -0,0 +1,23 @@
+// Loads arbitrary config JSON. Every profile that survives loading must
+// serialise back to JSON that loads as the same profile.
+#include "ConfigFile.h"
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    std::string text(reinterpret_cast<const char*>(data), size);
+    ConfigFileData cfg = ConfigFile::LoadFromString(text);
+
+    for (const auto& profile : cfg.profiles) {
+        std::string wrapped = "{\"profiles\":[" + ConfigFile::ProfileToJsonString(profile) + "]}";
+        ConfigFileData reloaded = ConfigFile::LoadFromString(wrapped);
+        if (reloaded.profiles.size() != 1 ||
+            reloaded.profiles[0].host != profile.host ||
+            reloaded.profiles[0].key != profile.key ||
+            reloaded.profiles[0].port != profile.port) {
+            std::abort();
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,27 @@
+// Drives ConnectionManager's message dispatch with arbitrary relay lines.
+// Speech and audio are never initialised, so handlers run their parsing and
+// bookkeeping without producing output; the clipboard is in-memory.
+#include "ConnectionManager.h"
+#include "Clipboard.h"
+#include "ClipboardBackend.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+std::atomic<bool> g_shutdown{false};
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    static ConnectionManager* manager = [] {
+#ifndef _WIN32
+        Clipboard::SetBackend(std::make_unique<FakeClipboardBackend>());
+#endif
+        auto* m = new ConnectionManager();
+        m->SetSpeechEnabled(true);
+        m->SetForwardAudioEnabled(true);
+        return m;
+    }();
+
+    manager->HandleIncomingMessage(std::string_view(reinterpret_cast<const char*>(data), size));
+    return 0;
+}
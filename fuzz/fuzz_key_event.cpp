@@ -0,0 +1,25 @@
+// Parses key events the way a relay would deliver them. Malformed JSON or
+// missing fields must surface as json exceptions, and anything accepted must
+// survive a ToJson/FromJson round trip unchanged.
+#include "KeyEvent.h"
+#include <cstdint>
+#include <cstdlib>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    json j = json::parse(data, data + size, nullptr, false);
+    if (j.is_discarded()) return 0;
+
+    KeyEvent event;
+    try {
+        event = KeyEvent::FromJson(j);
+    } catch (const json::exception&) {
+        return 0;
+    }
+
+    KeyEvent copy = KeyEvent::FromJson(event.ToJson());
+    if (copy.vk_code != event.vk_code || copy.scan_code != event.scan_code ||
+        copy.pressed != event.pressed || copy.extended != event.extended) {
+        std::abort();
+    }
+    return 0;
+}
@@ -0,0 +1,49 @@
+// Feeds the input to ReceiveFramer twice: whole, and split at chunk
+// boundaries taken from the first bytes of the input. Both runs must yield
+// the same messages, and the framer must never buffer more than its limit.
+#include "ReceiveFramer.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+    constexpr size_t MAX_MESSAGE = 64;
+    constexpr size_t BOUNDARY_BYTES = 8;
+
+    void Check(bool condition) {
+        if (!condition) std::abort();
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    size_t boundaries = std::min(size, BOUNDARY_BYTES);
+    const uint8_t* sizes = data;
+    const char* stream = reinterpret_cast<const char*>(data + boundaries);
+    const size_t length = size - boundaries;
+
+    std::vector<std::string> whole;
+    ReceiveFramer reference(MAX_MESSAGE);
+    reference.Feed(stream, length, [&](std::string_view line) {
+        Check(!line.empty() && line.size() <= MAX_MESSAGE);
+        Check(line.find('\n') == std::string_view::npos);
+        whole.emplace_back(line);
+    });
+
+    std::vector<std::string> chunked;
+    ReceiveFramer framer(MAX_MESSAGE);
+    size_t pos = 0;
+    for (size_t i = 0; pos < length; i++) {
+        size_t chunk = boundaries > 0 ? sizes[i % boundaries] % (MAX_MESSAGE * 2) + 1 : length;
+        chunk = std::min(chunk, length - pos);
+        framer.Feed(stream + pos, chunk, [&](std::string_view line) { chunked.emplace_back(line); });
+        Check(framer.Buffered() <= MAX_MESSAGE);
+        pos += chunk;
+    }
+
+    Check(whole == chunked);
+    Check(framer.Discarded() == reference.Discarded());
+    return 0;
+}
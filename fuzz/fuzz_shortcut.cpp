@@ -0,0 +1,13 @@
+// Parses arbitrary shortcut strings from config files and the command line,
+// then binds the result so the dispatch table rebuild is exercised too.
+#include "KeyboardState.h"
+#include <cstdint>
+#include <string>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    std::string shortcut(reinterpret_cast<const char*>(data), size);
+    KeyboardState::ParseShortcutString(shortcut);
+    KeyboardState::SetToggleShortcutAt(0, shortcut);
+    KeyboardState::ClearShortcuts();
+    return 0;
+}
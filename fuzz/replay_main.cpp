@@ -0,0 +1,73 @@
+// Standalone driver for the fuzz targets. Runs every input found under the
+// given files or directories through LLVMFuzzerTestOneInput, repeating the
+// set until -seconds have passed, and reports throughput so a slowdown in a
+// parser shows up next to the crash checks. Works with any compiler.
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+namespace fs = std::filesystem;
+
+static void LoadInputs(const fs::path& path, std::vector<std::string>& inputs) {
+    std::error_code ec;
+    if (fs::is_directory(path, ec)) {
+        for (const auto& entry : fs::recursive_directory_iterator(path, ec)) {
+            if (entry.is_regular_file()) LoadInputs(entry.path(), inputs);
+        }
+        return;
+    }
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::fprintf(stderr, "Cannot read %s\n", path.string().c_str());
+        return;
+    }
+    inputs.emplace_back(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+int main(int argc, char** argv) {
+    double seconds = 1.0;
+    std::vector<std::string> inputs;
+    for (int i = 1; i < argc; i++) {
+        if (std::strncmp(argv[i], "-seconds=", 9) == 0) {
+            seconds = std::atof(argv[i] + 9);
+        } else {
+            LoadInputs(argv[i], inputs);
+        }
+    }
+    if (inputs.empty()) {
+        std::fprintf(stderr, "usage: %s [-seconds=N] <corpus dir or file>...\n", argv[0]);
+        return 1;
+    }
+
+    size_t corpusBytes = 0;
+    for (const auto& input : inputs) corpusBytes += input.size();
+
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    uint64_t passes = 0;
+    double elapsed = 0.0;
+    do {
+        for (const auto& input : inputs) {
+            LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t*>(input.data()), input.size());
+        }
+        passes++;
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    } while (elapsed < seconds);
+
+    const double runs = static_cast<double>(passes * inputs.size());
+    const double bytes = static_cast<double>(passes * corpusBytes);
+    std::printf("%s: %zu inputs, %zu bytes, %llu passes in %.2f s: %.0f execs/s, %.2f MB/s\n",
+                fs::path(argv[0]).filename().string().c_str(), inputs.size(), corpusBytes,
+                static_cast<unsigned long long>(passes), elapsed,
+                runs / elapsed, bytes / elapsed / (1024.0 * 1024.0));
+    return 0;
+}
@@ -4,111 +4,226 @@
 #include "KeyEvent.h"
 #include "KeyboardState.h"
 #include "MessageSender.h"
+#include "RoutingState.h"
 #include "Speech.h"
 #include <algorithm>
 
-int AppState::g_activeProfile = -1;
-bool AppState::g_forwardingKeys = false;
-bool AppState::g_releasingKeys = false;
-std::vector<int> AppState::g_connectedProfiles;
-std::vector<std::string> AppState::g_profileNames;
+std::atomic<bool> AppState::g_releasingKeys{false};
+std::function<void(int, int)> AppState::g_profileSelectedCallback;
+
+namespace {
+    bool SendingKeys(const RoutingSnapshot& s) {
+        if (!s.forwardingKeys) return false;
+        return s.broadcasting ? !s.broadcastProfiles.empty() : s.activeProfile >= 0;
+    }
+}
 
 bool AppState::IsSendingKeys() {
-    return g_forwardingKeys && g_activeProfile >= 0;
+    return SendingKeys(*RoutingState::Read());
 }
 
+// Called from inside RoutingState::Update, so the decision to release and
+// the routing change it belongs to cannot interleave with another writer.
+// The releases go out through the snapshot still published, which is the
+// routing the keys were pressed under.
 void AppState::ReleaseAllKeys() {
     g_releasingKeys = true;
-    for (const auto& key : KeyboardState::GetAllPressedKeys()) {
+    for (const auto& key : KeyboardState::TakeAllPressedKeys()) {
         MessageSender::SendKeyEvent(KeyEvent(key.vkCode, false, key.scanCode, key.extended));
     }
-    KeyboardState::ClearPressedKeys();
     g_releasingKeys = false;
 }
 
 void AppState::AnnounceProfile(int profileIndex) {
     Audio::PlayTone(880, 100);
-    for (int i = 0; i < Config::isize(g_connectedProfiles); i++) {
-        if (g_connectedProfiles[i] == profileIndex && i < Config::isize(g_profileNames)) {
-            Speech::Speak(g_profileNames[i], true);
-            return;
+    std::string name;
+    {
+        auto routing = RoutingState::Read();
+        const auto& connected = routing->connectedProfiles;
+        for (int i = 0; i < Config::isize(connected); i++) {
+            if (connected[i] == profileIndex && i < Config::isize(routing->profileNames)) {
+                name = routing->profileNames[i];
+                break;
+            }
         }
     }
+    if (!name.empty()) Speech::Speak(name, true);
 }
 
-void AppState::SetActiveProfile(int profileIndex) {
-    if (g_forwardingKeys && g_activeProfile >= 0) {
-        ReleaseAllKeys();
-        g_forwardingKeys = false;
+void AppState::NotifySelected(int profileIndex, bool withNext) {
+    if (!g_profileSelectedCallback) return;
+    int nextProfile = -1;
+    if (withNext) {
+        auto routing = RoutingState::Read();
+        const auto& connected = routing->connectedProfiles;
+        auto it = std::find(connected.begin(), connected.end(), profileIndex);
+        if (it != connected.end() && connected.size() > 1) {
+            ++it;
+            nextProfile = it == connected.end() ? connected.front() : *it;
+        }
     }
-    g_activeProfile = profileIndex;
-    MessageSender::SetActiveProfile(profileIndex);
+    g_profileSelectedCallback(profileIndex, nextProfile);
+}
+
+void AppState::SetProfileSelectedCallback(std::function<void(int, int)> callback) {
+    g_profileSelectedCallback = std::move(callback);
+}
+
+void AppState::SetActiveProfile(int profileIndex) {
+    RoutingState::Update([&](RoutingSnapshot& s) {
+        if (SendingKeys(s)) {
+            ReleaseAllKeys();
+            s.forwardingKeys = false;
+        }
+        s.broadcasting = false;
+        s.activeProfile = profileIndex;
+    });
     AnnounceProfile(profileIndex);
+    NotifySelected(profileIndex);
 }
 
 void AppState::ToggleForwarding() {
-    if (g_activeProfile < 0) {
-        if (g_connectedProfiles.empty()) return;
-        g_activeProfile = g_connectedProfiles[0];
-        MessageSender::SetActiveProfile(g_activeProfile);
-    }
-
-    if (g_forwardingKeys) {
-        ReleaseAllKeys();
-        g_forwardingKeys = false;
+    bool toggled = false;
+    bool wasForwarding = false;
+    int activeProfile = -1;
+    RoutingState::Update([&](RoutingSnapshot& s) {
+        if (s.activeProfile < 0 && s.connectedProfiles.empty()) return;
+        toggled = true;
+        wasForwarding = s.forwardingKeys;
+        if (wasForwarding) ReleaseAllKeys();
+        if (s.activeProfile < 0) s.activeProfile = s.connectedProfiles[0];
+        s.forwardingKeys = !wasForwarding && s.activeProfile >= 0;
+        s.broadcasting = false;
+        activeProfile = s.activeProfile;
+    });
+    if (!toggled) return;
+
+    if (wasForwarding) {
         Audio::PlayTone(440, 100);
         Speech::Speak("Local", true);
-    } else {
-        g_forwardingKeys = true;
-        AnnounceProfile(g_activeProfile);
+    } else if (activeProfile >= 0) {
+        AnnounceProfile(activeProfile);
+        NotifySelected(activeProfile);
     }
 }
 
 void AppState::CycleProfile() {
-    if (g_connectedProfiles.empty()) return;
+    int nextProfile = -1;
+    RoutingState::Update([&](RoutingSnapshot& s) {
+        if (s.connectedProfiles.empty()) return;
+        if (s.forwardingKeys) ReleaseAllKeys();
+        s.forwardingKeys = false;
+        s.broadcasting = false;
+
+        int currentIdx = -1;
+        for (int i = 0; i < Config::isize(s.connectedProfiles); i++) {
+            if (s.connectedProfiles[i] == s.activeProfile) {
+                currentIdx = i;
+                break;
+            }
+        }
 
-    if (g_forwardingKeys) {
-        ReleaseAllKeys();
-        g_forwardingKeys = false;
-    }
+        int nextIdx = (currentIdx + 1) % Config::isize(s.connectedProfiles);
+        s.activeProfile = s.connectedProfiles[nextIdx];
+        nextProfile = s.activeProfile;
+    });
 
-    int currentIdx = -1;
-    for (int i = 0; i < Config::isize(g_connectedProfiles); i++) {
-        if (g_connectedProfiles[i] == g_activeProfile) {
-            currentIdx = i;
-            break;
-        }
+    if (nextProfile >= 0) {
+        AnnounceProfile(nextProfile);
+        NotifySelected(nextProfile);
     }
-
-    int nextIdx = (currentIdx + 1) % Config::isize(g_connectedProfiles);
-    g_activeProfile = g_connectedProfiles[nextIdx];
-    MessageSender::SetActiveProfile(g_activeProfile);
-    AnnounceProfile(g_activeProfile);
 }
 
 void AppState::SetConnectedProfiles(const std::vector<int>& indices, const std::vector<std::string>& names) {
-    g_connectedProfiles = indices;
-    g_profileNames = names;
-
-    if (g_activeProfile >= 0) {
-        bool stillConnected = std::find(indices.begin(), indices.end(), g_activeProfile) != indices.end();
-        if (!stillConnected) {
-            if (g_forwardingKeys) ReleaseAllKeys();
-            g_forwardingKeys = false;
-            g_activeProfile = -1;
+    RoutingState::Update([&](RoutingSnapshot& s) {
+        s.connectedProfiles = indices;
+        s.profileNames = names;
+
+        if (s.activeProfile >= 0 &&
+            std::find(indices.begin(), indices.end(), s.activeProfile) == indices.end()) {
+            if (s.forwardingKeys) ReleaseAllKeys();
+            s.forwardingKeys = false;
+            s.activeProfile = -1;
         }
-    }
 
-    if (g_activeProfile < 0 && !indices.empty()) {
-        g_activeProfile = indices[0];
-        MessageSender::SetActiveProfile(g_activeProfile);
+        if (s.activeProfile < 0 && !indices.empty()) {
+            s.activeProfile = indices[0];
+        }
+    });
+}
+
+void AppState::ToggleBroadcast() {
+    enum class Outcome { NoGroup, Started, Stopped } outcome = Outcome::NoGroup;
+    size_t targetCount = 0;
+    std::vector<int> targets;
+    RoutingState::Update([&](RoutingSnapshot& s) {
+        if (!s.broadcasting && s.broadcastProfiles.empty()) return;
+        if (SendingKeys(s)) ReleaseAllKeys();
+        outcome = s.broadcasting ? Outcome::Stopped : Outcome::Started;
+        s.broadcasting = outcome == Outcome::Started;
+        s.forwardingKeys = s.broadcasting;
+        targetCount = s.broadcastProfiles.size();
+        targets = s.broadcastProfiles;
+    });
+
+    switch (outcome) {
+        case Outcome::NoGroup:
+            Speech::Speak("No broadcast profiles connected", true);
+            break;
+        case Outcome::Stopped:
+            Audio::PlayTone(440, 100);
+            Speech::Speak("Local", true);
+            break;
+        case Outcome::Started:
+            Audio::PlayTone(880, 100);
+            Speech::Speak("Broadcast to " + std::to_string(targetCount) + " profiles", true);
+            for (int profile : targets) NotifySelected(profile, false);
+            break;
     }
 }
 
+void AppState::SetBroadcastProfiles(const std::vector<int>& indices) {
+    RoutingState::Update([&](RoutingSnapshot& s) {
+        s.broadcastProfiles = indices;
+        if (s.broadcasting && indices.empty()) {
+            if (s.forwardingKeys) ReleaseAllKeys();
+            s.broadcasting = false;
+            s.forwardingKeys = false;
+        }
+    });
+}
+
+// The profile keeps its place while it reconnects. Keys only return to local
+// control if they were going to that profile alone.
+void AppState::HandleProfileLost(int profileIndex) {
+    bool returnedToLocal = false;
+    RoutingState::Update([&](RoutingSnapshot& s) {
+        if (!s.forwardingKeys || s.broadcasting || s.activeProfile != profileIndex) return;
+        ReleaseAllKeys();
+        s.forwardingKeys = false;
+        returnedToLocal = true;
+    });
+    if (!returnedToLocal) return;
+    Audio::PlayTone(440, 100);
+    Speech::Speak("Local", true);
+}
+
+bool AppState::IsBroadcasting() {
+    return RoutingState::Read()->broadcasting;
+}
+
 bool AppState::IsReleasingKeys() {
     return g_releasingKeys;
 }
 
 int AppState::GetActiveProfile() {
-    return g_activeProfile;
+    return RoutingState::Read()->activeProfile;
+}
+
+bool AppState::IsReceivingKeys(int profileIndex) {
+    auto routing = RoutingState::Read();
+    if (!routing->forwardingKeys || profileIndex < 0) return false;
+    if (!routing->broadcasting) return routing->activeProfile == profileIndex;
+    const auto& targets = routing->broadcastProfiles;
+    return std::find(targets.begin(), targets.end(), profileIndex) != targets.end();
 }
@@ -1,24 +1,33 @@
 #pragma once
+#include <atomic>
+#include <functional>
 #include <vector>
 #include <string>
 
 class AppState {
 private:
-    static int g_activeProfile;
-    static bool g_forwardingKeys;
-    static bool g_releasingKeys;
-    static std::vector<int> g_connectedProfiles;
-    static std::vector<std::string> g_profileNames;
+    static std::atomic<bool> g_releasingKeys;
+    static std::function<void(int, int)> g_profileSelectedCallback;
 
     static void ReleaseAllKeys();
     static void AnnounceProfile(int profileIndex);
+    static void NotifySelected(int profileIndex, bool withNext = true);
 
 public:
     static bool IsSendingKeys();
     static void SetActiveProfile(int profileIndex);
     static void ToggleForwarding();
     static void CycleProfile();
+    static void ToggleBroadcast();
     static void SetConnectedProfiles(const std::vector<int>& indices, const std::vector<std::string>& names);
+    static void SetBroadcastProfiles(const std::vector<int>& indices);
+    static void HandleProfileLost(int profileIndex);
+    static bool IsBroadcasting();
     static bool IsReleasingKeys();
     static int GetActiveProfile();
+    static bool IsReceivingKeys(int profileIndex);
+    // Called on the keyboard thread when a profile is selected or starts
+    // receiving keys, with the profile after it in cycle order (or -1), so
+    // on-demand profiles can connect. Set before the keyboard hook starts.
+    static void SetProfileSelectedCallback(std::function<void(int profileIndex, int nextProfileIndex)> callback);
 };
@@ -3,8 +3,12 @@
 #include <vector>
 #include <thread>
 #include <filesystem>
-#include <algorithm>
 #include <atomic>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <optional>
+#include <unordered_map>
 
 static std::atomic<bool> g_audioEnabled{true};
 
@@ -13,79 +17,170 @@ static std::atomic<bool> g_audioEnabled{true};
 #include <mmsystem.h>
 #pragma comment(lib, "winmm.lib")
 #else
-// Linux implementation stub or use pulse/alsa if needed
+#include "AudioMixer.h"
 #endif
 
 namespace fs = std::filesystem;
 
-void Audio::SetEnabled(bool enabled) { g_audioEnabled = enabled; }
-bool Audio::IsEnabled() { return g_audioEnabled; }
-
-void Audio::PlayTone(int hz, int length) {
-    if (!g_audioEnabled) return;
+namespace {
+    // Filled once by Audio::Initialize and read-only after, so the receive
+    // threads look sounds up without a lock and never touch the disk.
+    std::once_flag g_soundsOnce;
+    std::atomic<bool> g_soundsLoaded{false};
 #ifdef _WIN32
-    std::thread([hz, length]() {
-        Beep(static_cast<DWORD>(hz), static_cast<DWORD>(length));
-    }).detach();
+    std::unordered_map<std::string, std::string> g_sounds;
+
+    // Beep blocks for the tone's duration, so tones run on one worker. A tone
+    // that arrives while another is sounding replaces any tone still waiting.
+    struct PendingTone {
+        int hz;
+        int length;
+    };
+    std::mutex g_toneMutex;
+    std::condition_variable g_toneCv;
+    std::optional<PendingTone> g_pendingTone;
+    bool g_toneStopping = false;
+    std::thread g_toneThread;
+
+    void ToneThreadLoop() {
+        while (true) {
+            PendingTone tone;
+            {
+                std::unique_lock<std::mutex> lock(g_toneMutex);
+                g_toneCv.wait(lock, [] { return g_toneStopping || g_pendingTone.has_value(); });
+                if (g_toneStopping) return;
+                tone = *g_pendingTone;
+                g_pendingTone.reset();
+            }
+            Beep(static_cast<DWORD>(tone.hz), static_cast<DWORD>(tone.length));
+        }
+    }
 #else
-    DEBUG_WARN("AUDIO", "PlayTone not implemented on Linux");
+    std::unordered_map<std::string, std::shared_ptr<const PcmBuffer>> g_sounds;
+    std::unique_ptr<AudioMixer> g_mixer;
 #endif
-}
-
-void Audio::PlayWave(const std::string& fileName) {
-    if (!g_audioEnabled) return;
-    if (fileName.empty()) return;
 
-    std::vector<std::string> searchPaths = {
-        "sounds",
-        "../../sounds",
-        "../NVDARemote/addon/sounds",
-        "../../NVDARemote/addon/sounds",
-    };
+    std::vector<fs::path> ResolveSoundDirs() {
+        std::vector<std::string> searchPaths = {
+            "sounds",
+            "../../sounds",
+            "../NVDARemote/addon/sounds",
+            "../../NVDARemote/addon/sounds",
+        };
 
 #ifdef _WIN32
-    const char* programFiles = getenv("ProgramFiles");
-    const char* programFilesX86 = getenv("ProgramFiles(x86)");
-    const char* appData = getenv("AppData");
+        const char* programFiles = getenv("ProgramFiles");
+        const char* programFilesX86 = getenv("ProgramFiles(x86)");
 
-    if (programFiles) {
-        searchPaths.push_back(std::string(programFiles) + "\\NVDA\\waves");
-    }
-    if (programFilesX86) {
-        searchPaths.push_back(std::string(programFilesX86) + "\\NVDA\\waves");
-    }
+        if (programFiles) {
+            searchPaths.push_back(std::string(programFiles) + "\\NVDA\\waves");
+        }
+        if (programFilesX86) {
+            searchPaths.push_back(std::string(programFilesX86) + "\\NVDA\\waves");
+        }
 #endif
 
-    std::string fullPath;
-    for (const auto& path : searchPaths) {
-        try {
-            auto p = fs::path(path) / fileName;
-            if (!p.has_extension()) {
-                p.replace_extension(".wav");
+        std::vector<fs::path> dirs;
+        for (const auto& path : searchPaths) {
+            std::error_code ec;
+            if (fs::is_directory(path, ec)) {
+                dirs.push_back(fs::absolute(path, ec));
+                DEBUG_VERBOSE_F("AUDIO", "Sound directory: {}", dirs.back().string());
             }
-            
-            if (fs::exists(p)) {
-                fullPath = fs::absolute(p).string();
-                break;
+        }
+        if (dirs.empty()) {
+            DEBUG_WARN("AUDIO", "No sound directory found");
+        }
+        return dirs;
+    }
+
+    // Keys are file names with the extension, so "connected" and
+    // "connected.wav" find the same sound. An earlier directory wins.
+    std::string SoundKey(const std::string& fileName) {
+        fs::path p(fileName);
+        if (!p.has_extension()) p.replace_extension(".wav");
+        return p.string();
+    }
+
+    void LoadSounds() {
+        for (const auto& dir : ResolveSoundDirs()) {
+            std::error_code ec;
+            for (const auto& entry : fs::directory_iterator(dir, ec)) {
+                if (!entry.is_regular_file(ec) || entry.path().extension() != ".wav") continue;
+                std::string key = entry.path().filename().string();
+                if (g_sounds.count(key)) continue;
+#ifdef _WIN32
+                g_sounds.emplace(key, entry.path().string());
+#else
+                if (auto pcm = DecodeWavFile(entry.path().string())) g_sounds.emplace(key, std::move(pcm));
+#endif
             }
-        } catch (...) {
-            continue;
         }
+        DEBUG_VERBOSE_F("AUDIO", "Loaded {} sounds", g_sounds.size());
+        g_soundsLoaded = true;
     }
+}
 
-    if (fullPath.empty()) {
+void Audio::Initialize() {
+#ifdef _WIN32
+    std::call_once(g_soundsOnce, LoadSounds);
+    if (!g_toneThread.joinable()) {
+        g_toneThread = std::thread(ToneThreadLoop);
+    }
+#else
+    if (g_audioEnabled && !g_mixer) {
+        std::call_once(g_soundsOnce, LoadSounds);
+        g_mixer = std::make_unique<AudioMixer>(std::make_unique<AplaySink>());
+    }
+#endif
+}
+
+void Audio::Cleanup() {
+#ifdef _WIN32
+    {
+        std::lock_guard<std::mutex> lock(g_toneMutex);
+        g_toneStopping = true;
+    }
+    g_toneCv.notify_all();
+    if (g_toneThread.joinable()) g_toneThread.join();
+#else
+    if (g_mixer) g_mixer->Stop();
+#endif
+}
+
+void Audio::SetEnabled(bool enabled) { g_audioEnabled = enabled; }
+bool Audio::IsEnabled() { return g_audioEnabled; }
+
+void Audio::PlayTone(int hz, int length) {
+    if (!g_audioEnabled) return;
+#ifdef _WIN32
+    {
+        std::lock_guard<std::mutex> lock(g_toneMutex);
+        g_pendingTone = PendingTone{hz, length};
+    }
+    g_toneCv.notify_one();
+#else
+    if (g_mixer) g_mixer->PlayTone(hz, length);
+#endif
+}
+
+void Audio::PlayWave(const std::string& fileName) {
+    if (!g_audioEnabled) return;
+    if (fileName.empty() || !g_soundsLoaded) return;
+
+    auto it = g_sounds.find(SoundKey(fileName));
+    if (it == g_sounds.end()) {
         DEBUG_WARN_F("AUDIO", "Sound file not found: {}", fileName);
         return;
     }
 
-    DEBUG_VERBOSE_F("AUDIO", "Playing sound: {}", fullPath);
-
 #ifdef _WIN32
-    PlaySoundA(fullPath.c_str(), NULL, SND_ASYNC | SND_FILENAME | SND_NODEFAULT);
+    DEBUG_VERBOSE_F("AUDIO", "Playing sound: {}", it->second);
+    PlaySoundA(it->second.c_str(), NULL, SND_ASYNC | SND_FILENAME | SND_NODEFAULT);
 #else
-    std::thread([fullPath]() {
-        std::string cmd = "aplay \"" + fullPath + "\" >/dev/null 2>&1";
-        system(cmd.c_str());
-    }).detach();
+    if (!g_mixer) return;
+
+    DEBUG_VERBOSE_F("AUDIO", "Playing sound: {}", fileName);
+    g_mixer->Play(it->second);
 #endif
 }
@@ -3,6 +3,8 @@
 
 class Audio {
 public:
+    static void Initialize();
+    static void Cleanup();
     static void SetEnabled(bool enabled);
     static bool IsEnabled();
     static void PlayTone(int hz, int length);
@@ -0,0 +1,241 @@
+#include "AudioMixer.h"
+#include "Debug.h"
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+AplaySink::AplaySink() {
+    // A dead aplay must surface as a failed write, not kill the process.
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::string cmd = "aplay -q -t raw -f S16_LE -c " + std::to_string(AudioMixer::CHANNELS) +
+                      " -r " + std::to_string(AudioMixer::SAMPLE_RATE) + " - >/dev/null 2>&1";
+    m_pipe = popen(cmd.c_str(), "w");
+    if (!m_pipe) {
+        DEBUG_WARN("AUDIO", "Failed to start aplay - sound output disabled");
+        m_failed = true;
+    }
+}
+
+AplaySink::~AplaySink() {
+    if (m_pipe) pclose(m_pipe);
+}
+
+bool AplaySink::Write(const int16_t* samples, size_t frames) {
+    if (m_failed) return false;
+    size_t count = frames * AudioMixer::CHANNELS;
+    if (fwrite(samples, sizeof(int16_t), count, m_pipe) != count || fflush(m_pipe) != 0) {
+        DEBUG_WARN("AUDIO", "aplay exited - sound output disabled");
+        m_failed = true;
+        return false;
+    }
+    return true;
+}
+
+namespace {
+    uint16_t ReadU16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+    uint32_t ReadU32(const uint8_t* p) { return ReadU16(p) | (static_cast<uint32_t>(ReadU16(p + 2)) << 16); }
+
+    constexpr uint16_t WAVE_FORMAT_PCM = 1;
+    constexpr uint16_t WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
+}
+
+std::shared_ptr<const PcmBuffer> DecodeWavFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return nullptr;
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    if (data.size() < 12 || std::memcmp(data.data(), "RIFF", 4) != 0 || std::memcmp(data.data() + 8, "WAVE", 4) != 0) {
+        DEBUG_WARN_F("AUDIO", "Not a WAV file: {}", path);
+        return nullptr;
+    }
+
+    uint16_t format = 0, channels = 0, bits = 0;
+    uint32_t rate = 0;
+    const uint8_t* pcm = nullptr;
+    size_t pcmBytes = 0;
+
+    size_t pos = 12;
+    while (pos + 8 <= data.size()) {
+        uint32_t chunkSize = ReadU32(&data[pos + 4]);
+        const uint8_t* body = &data[pos + 8];
+        size_t available = std::min<size_t>(chunkSize, data.size() - pos - 8);
+
+        if (std::memcmp(&data[pos], "fmt ", 4) == 0 && available >= 16) {
+            format = ReadU16(body);
+            channels = ReadU16(body + 2);
+            rate = ReadU32(body + 4);
+            bits = ReadU16(body + 14);
+        } else if (std::memcmp(&data[pos], "data", 4) == 0) {
+            pcm = body;
+            pcmBytes = available;
+        }
+        pos += 8 + chunkSize + (chunkSize & 1);
+    }
+
+    if ((format != WAVE_FORMAT_PCM && format != WAVE_FORMAT_EXTENSIBLE) ||
+        (bits != 8 && bits != 16) || channels == 0 || rate == 0 || !pcm) {
+        DEBUG_WARN_F("AUDIO", "Unsupported WAV format in {} (format={}, bits={}, channels={})",
+                     path, format, bits, channels);
+        return nullptr;
+    }
+
+    const size_t bytesPerSample = bits / 8;
+    const size_t srcFrames = pcmBytes / (bytesPerSample * channels);
+    auto sample = [&](size_t frame, size_t channel) -> int {
+        const uint8_t* p = pcm + (frame * channels + std::min<size_t>(channel, channels - 1)) * bytesPerSample;
+        return bits == 8 ? (static_cast<int>(p[0]) - 128) << 8 : static_cast<int16_t>(ReadU16(p));
+    };
+
+    auto out = std::make_shared<PcmBuffer>();
+    if (srcFrames == 0) return out;
+
+    const double step = static_cast<double>(rate) / AudioMixer::SAMPLE_RATE;
+    const size_t outFrames = static_cast<size_t>(srcFrames / step);
+    out->samples.resize(outFrames * AudioMixer::CHANNELS);
+
+    for (size_t i = 0; i < outFrames; i++) {
+        double srcPos = i * step;
+        size_t f0 = static_cast<size_t>(srcPos);
+        size_t f1 = std::min(f0 + 1, srcFrames - 1);
+        double t = srcPos - f0;
+        for (int c = 0; c < AudioMixer::CHANNELS; c++) {
+            double v = sample(f0, c) * (1.0 - t) + sample(f1, c) * t;
+            out->samples[i * AudioMixer::CHANNELS + c] = static_cast<int16_t>(v);
+        }
+    }
+
+    DEBUG_VERBOSE_F("AUDIO", "Decoded {} ({} Hz, {} ch, {} bit, {} frames)", path, rate, channels, bits, outFrames);
+    return out;
+}
+
+AudioMixer::AudioMixer(std::unique_ptr<AudioSink> sink) : m_sink(std::move(sink)) {
+    m_thread = std::thread([this] { Run(); });
+}
+
+AudioMixer::~AudioMixer() {
+    Stop();
+}
+
+void AudioMixer::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_cv.notify_all();
+    if (m_thread.joinable()) m_thread.join();
+}
+
+void AudioMixer::Play(std::shared_ptr<const PcmBuffer> pcm) {
+    if (!pcm || pcm->Frames() == 0) return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending.push_back({std::move(pcm), 0});
+    }
+    m_cv.notify_one();
+}
+
+void AudioMixer::PlayTone(int hz, int lengthMs, ToneWave wave, bool overlap) {
+    if (hz <= 0 || lengthMs <= 0 || hz >= SAMPLE_RATE / 2) return;
+
+    Voice voice;
+    voice.isTone = true;
+    voice.cancelsTones = !overlap;
+    voice.wave = wave;
+    voice.phaseStep = static_cast<double>(hz) / SAMPLE_RATE;
+    voice.toneFrames = static_cast<size_t>(lengthMs) * SAMPLE_RATE / 1000;
+    voice.releaseAt = voice.toneFrames > TONE_FADE_FRAMES ? voice.toneFrames - TONE_FADE_FRAMES : 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending.push_back(voice);
+    }
+    m_cv.notify_one();
+}
+
+void AudioMixer::MixTone(Voice& voice, int32_t* accum, size_t frames) {
+    constexpr double TWO_PI = 6.283185307179586;
+    for (size_t i = 0; i < frames; i++, voice.frame++) {
+        double gain = 1.0;
+        if (voice.frame < TONE_FADE_FRAMES) {
+            gain = static_cast<double>(voice.frame) / TONE_FADE_FRAMES;
+        }
+        if (voice.frame >= voice.releaseAt) {
+            size_t remaining = voice.toneFrames - voice.frame;
+            gain = std::min(gain, static_cast<double>(remaining) / TONE_FADE_FRAMES);
+        }
+
+        double v = voice.wave == ToneWave::Sine ? std::sin(TWO_PI * voice.phase)
+                                                : (voice.phase < 0.5 ? 1.0 : -1.0);
+        voice.phase += voice.phaseStep;
+        if (voice.phase >= 1.0) voice.phase -= 1.0;
+
+        int32_t s = static_cast<int32_t>(v * gain * TONE_AMPLITUDE);
+        accum[i * CHANNELS] += s;
+        accum[i * CHANNELS + 1] += s;
+    }
+}
+
+void AudioMixer::Run() {
+    using Clock = std::chrono::steady_clock;
+
+    std::vector<Voice> active;
+    std::vector<int32_t> accum(BLOCK_FRAMES * CHANNELS);
+    std::vector<int16_t> block(BLOCK_FRAMES * CHANNELS);
+    Clock::time_point streamStart;
+    uint64_t framesWritten = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (active.empty()) {
+                m_cv.wait(lock, [this] { return m_stopping || !m_pending.empty(); });
+                streamStart = Clock::now();
+                framesWritten = 0;
+            }
+            if (m_stopping) break;
+            for (auto& voice : m_pending) {
+                if (voice.cancelsTones) {
+                    for (auto& playing : active) {
+                        if (!playing.isTone) continue;
+                        size_t fade = playing.frame == 0 ? 0 : TONE_FADE_FRAMES;
+                        playing.toneFrames = std::min(playing.toneFrames, playing.frame + fade);
+                        playing.releaseAt = std::min(playing.releaseAt, playing.frame);
+                    }
+                }
+                active.push_back(std::move(voice));
+            }
+            m_pending.clear();
+        }
+
+        std::fill(accum.begin(), accum.end(), 0);
+        for (auto& voice : active) {
+            size_t frames = std::min<size_t>(BLOCK_FRAMES, voice.Frames() - voice.frame);
+            if (voice.isTone) {
+                MixTone(voice, accum.data(), frames);
+                continue;
+            }
+            const int16_t* src = voice.pcm->samples.data() + voice.frame * CHANNELS;
+            for (size_t i = 0; i < frames * CHANNELS; i++) accum[i] += src[i];
+            voice.frame += frames;
+        }
+        active.erase(std::remove_if(active.begin(), active.end(),
+                                    [](const Voice& v) { return v.frame >= v.Frames(); }),
+                     active.end());
+
+        for (size_t i = 0; i < accum.size(); i++) {
+            block[i] = static_cast<int16_t>(std::clamp<int32_t>(accum[i], INT16_MIN, INT16_MAX));
+        }
+        m_sink->Write(block.data(), BLOCK_FRAMES);
+        framesWritten += BLOCK_FRAMES;
+
+        if (m_sink->IsRealtime()) {
+            auto due = streamStart + std::chrono::microseconds(framesWritten * 1000000 / SAMPLE_RATE)
+                                   - std::chrono::milliseconds(MAX_LEAD_MS);
+            std::this_thread::sleep_until(due);
+        }
+    }
+}
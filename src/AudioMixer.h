@@ -0,0 +1,107 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Interleaved stereo S16 at AudioMixer::SAMPLE_RATE.
+struct PcmBuffer {
+    std::vector<int16_t> samples;
+    size_t Frames() const { return samples.size() / 2; }
+};
+
+class AudioSink {
+public:
+    virtual ~AudioSink() = default;
+    virtual bool Write(const int16_t* samples, size_t frames) = 0;
+    virtual bool IsRealtime() const { return true; }
+};
+
+// Discards audio as fast as the mixer produces it. The frame count can be
+// read from any thread.
+class NullSink : public AudioSink {
+private:
+    std::atomic<size_t> m_framesWritten{0};
+
+public:
+    bool Write(const int16_t*, size_t frames) override { m_framesWritten += frames; return true; }
+    bool IsRealtime() const override { return false; }
+    size_t FramesWritten() const { return m_framesWritten; }
+};
+
+// Streams raw PCM into one long-lived aplay process.
+class AplaySink : public AudioSink {
+private:
+    FILE* m_pipe = nullptr;
+    bool m_failed = false;
+
+public:
+    AplaySink();
+    ~AplaySink() override;
+    bool Write(const int16_t* samples, size_t frames) override;
+};
+
+std::shared_ptr<const PcmBuffer> DecodeWavFile(const std::string& path);
+
+enum class ToneWave : uint8_t {
+    Sine,
+    Square
+};
+
+// One output thread mixes every active sound into fixed-size blocks and
+// writes them to the sink. Realtime sinks are paced so the output never runs
+// more than MAX_LEAD_MS ahead of the device, which keeps new sounds from
+// queueing behind buffered audio. Tones are synthesized on the same thread;
+// a new tone fades out the tones still playing unless it is asked to overlap.
+class AudioMixer {
+public:
+    static constexpr int SAMPLE_RATE = 44100;
+    static constexpr int CHANNELS = 2;
+    static constexpr int BLOCK_FRAMES = SAMPLE_RATE / 100;
+    static constexpr int MAX_LEAD_MS = 40;
+    static constexpr int TONE_FADE_FRAMES = SAMPLE_RATE / 200;
+    static constexpr int TONE_AMPLITUDE = 8000;
+
+private:
+    struct Voice {
+        std::shared_ptr<const PcmBuffer> pcm;
+        size_t frame = 0;
+
+        bool isTone = false;
+        bool cancelsTones = false;
+        ToneWave wave = ToneWave::Sine;
+        double phase = 0.0;
+        double phaseStep = 0.0;
+        size_t toneFrames = 0;
+        size_t releaseAt = 0;
+
+        size_t Frames() const { return isTone ? toneFrames : pcm->Frames(); }
+    };
+
+    static void MixTone(Voice& voice, int32_t* accum, size_t frames);
+
+    std::unique_ptr<AudioSink> m_sink;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::vector<Voice> m_pending;
+    bool m_stopping = false;
+    std::thread m_thread;
+
+    void Run();
+
+public:
+    explicit AudioMixer(std::unique_ptr<AudioSink> sink);
+    ~AudioMixer();
+
+    AudioMixer(const AudioMixer&) = delete;
+    AudioMixer& operator=(const AudioMixer&) = delete;
+
+    void Play(std::shared_ptr<const PcmBuffer> pcm);
+    void PlayTone(int hz, int lengthMs, ToneWave wave = ToneWave::Sine, bool overlap = false);
+    void Stop();
+};
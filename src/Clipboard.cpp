@@ -37,36 +37,99 @@ void Clipboard::SetText(const std::string& text) {
 
 #else
 
+#include "ClipboardBackend.h"
+#include "Debug.h"
 #include <cstdio>
-#include <array>
+#include <cstdlib>
+#include <vector>
 
-static std::string RunPipeOut(const char* cmd) {
-    std::string result;
-    FILE* pipe = popen(cmd, "r");
-    if (!pipe) return result;
-    std::array<char, 512> buf;
-    while (fgets(buf.data(), static_cast<int>(buf.size()), pipe))
-        result += buf.data();
-    pclose(pipe);
-    return result;
+namespace {
+    constexpr size_t PIPE_READ_CHUNK = 64 * 1024;
+
+    bool RunPipeOut(const char* cmd, std::string& out) {
+        FILE* pipe = popen(cmd, "r");
+        if (!pipe) return false;
+        std::vector<char> buf(PIPE_READ_CHUNK);
+        size_t n;
+        while ((n = fread(buf.data(), 1, buf.size(), pipe)) > 0)
+            out.append(buf.data(), n);
+        return pclose(pipe) == 0;
+    }
+
+    bool RunPipeIn(const char* cmd, const std::string& data) {
+        FILE* pipe = popen(cmd, "w");
+        if (!pipe) return false;
+        fwrite(data.data(), 1, data.size(), pipe);
+        return pclose(pipe) == 0;
+    }
+
+    class CommandClipboardBackend : public ClipboardBackend {
+    private:
+        bool m_wayland = getenv("WAYLAND_DISPLAY") != nullptr;
+
+    public:
+        const char* Name() const override { return m_wayland ? "wl-clipboard" : "xclip"; }
+
+        bool GetText(std::string& out) override {
+            if (m_wayland) return RunPipeOut("wl-paste --no-newline 2>/dev/null", out);
+            if (RunPipeOut("xclip -selection clipboard -o 2>/dev/null", out)) return true;
+            out.clear();
+            return RunPipeOut("xsel --clipboard --output 2>/dev/null", out);
+        }
+
+        bool SetText(const std::string& text) override {
+            if (m_wayland) return RunPipeIn("wl-copy 2>/dev/null", text);
+            return RunPipeIn("xclip -selection clipboard 2>/dev/null", text) ||
+                   RunPipeIn("xsel --clipboard --input 2>/dev/null", text);
+        }
+    };
+
+    std::mutex g_backendMutex;
+    std::unique_ptr<ClipboardBackend> g_backend;
+
+    std::unique_ptr<ClipboardBackend> SelectBackend() {
+        const char* requested = getenv("NVDAREMOTE_CLIPBOARD");
+        std::string choice = requested ? requested : "";
+        if (choice == "fake") return std::make_unique<FakeClipboardBackend>();
+        if (choice == "command") return CreateCommandClipboardBackend();
+#ifdef HAVE_X11
+        bool preferX11 = choice == "x11" || getenv("WAYLAND_DISPLAY") == nullptr;
+        if (preferX11 && getenv("DISPLAY")) {
+            if (auto x11 = CreateX11ClipboardBackend()) return x11;
+        }
+#endif
+        return CreateCommandClipboardBackend();
+    }
+
+    ClipboardBackend& Backend() {
+        std::lock_guard<std::mutex> lock(g_backendMutex);
+        if (!g_backend) {
+            g_backend = SelectBackend();
+            DEBUG_VERBOSE_F("CLIP", "Clipboard backend: {}", g_backend->Name());
+        }
+        return *g_backend;
+    }
+}
+
+std::unique_ptr<ClipboardBackend> CreateCommandClipboardBackend() {
+    return std::make_unique<CommandClipboardBackend>();
 }
 
-static bool RunPipeIn(const char* cmd, const std::string& data) {
-    FILE* pipe = popen(cmd, "w");
-    if (!pipe) return false;
-    fwrite(data.c_str(), 1, data.size(), pipe);
-    return pclose(pipe) == 0;
+void Clipboard::SetBackend(std::unique_ptr<ClipboardBackend> backend) {
+    std::lock_guard<std::mutex> lock(g_backendMutex);
+    g_backend = std::move(backend);
 }
 
 std::string Clipboard::GetText() {
-    std::string result = RunPipeOut("xclip -selection clipboard -o 2>/dev/null");
-    if (result.empty()) result = RunPipeOut("xsel --clipboard --output 2>/dev/null");
+    std::string result;
+    if (!Backend().GetText(result)) result.clear();
     return result;
 }
 
 void Clipboard::SetText(const std::string& text) {
-    if (!RunPipeIn("xclip -selection clipboard 2>/dev/null", text))
-        RunPipeIn("xsel --clipboard --input 2>/dev/null", text);
+    if (!Backend().SetText(text)) {
+        DEBUG_WARN("CLIP", "Failed to set clipboard text");
+    }
 }
 
 #endif
@@ -1,8 +1,14 @@
 #pragma once
 #include <string>
+#include <memory>
+
+class ClipboardBackend;
 
 class Clipboard {
 public:
     static std::string GetText();
     static void SetText(const std::string& text);
+#ifndef _WIN32
+    static void SetBackend(std::unique_ptr<ClipboardBackend> backend);
+#endif
 };
@@ -0,0 +1,41 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <string>
+
+class ClipboardBackend {
+public:
+    virtual ~ClipboardBackend() = default;
+    virtual const char* Name() const = 0;
+    virtual bool GetText(std::string& out) = 0;
+    virtual bool SetText(const std::string& text) = 0;
+};
+
+// In-memory clipboard for headless runs (NVDAREMOTE_CLIPBOARD=fake).
+class FakeClipboardBackend : public ClipboardBackend {
+private:
+    std::mutex m_mutex;
+    std::string m_text;
+
+public:
+    const char* Name() const override { return "fake"; }
+    bool GetText(std::string& out) override {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        out = m_text;
+        return true;
+    }
+    bool SetText(const std::string& text) override {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_text = text;
+        return true;
+    }
+};
+
+// wl-paste/wl-copy under Wayland, xclip or xsel otherwise.
+std::unique_ptr<ClipboardBackend> CreateCommandClipboardBackend();
+
+#ifdef HAVE_X11
+// Owns the CLIPBOARD selection from a persistent thread with its own X
+// connection. Returns nullptr when no display is available.
+std::unique_ptr<ClipboardBackend> CreateX11ClipboardBackend();
+#endif
@@ -6,8 +6,11 @@
 #include "MessageSender.h"
 #include "KeyboardState.h"
 #include "AppState.h"
+#include "SpeechQueue.h"
+#include "DnsCache.h"
 #include <iostream>
 #include <sstream>
+#include <iomanip>
 #include <algorithm>
 #include <unordered_map>
 #ifdef _WIN32
@@ -17,6 +20,16 @@ extern DWORD g_mainThreadId;
 #endif
 
 namespace {
+    // A new connect timeout applies from the session's next attempt.
+    std::function<bool(ProfileSession&, const std::string&)> TimeoutApplier(int ProfileConfig::*field) {
+        return [field](ProfileSession& s, const std::string& v) {
+            try { s.config.*field = std::stoi(v); }
+            catch (...) { std::cout << "Invalid timeout" << std::endl; return false; }
+            if (s.connection) s.connection->ApplyConnectTimeouts(s.config);
+            return true;
+        };
+    }
+
     using ValidatorFunc = std::function<Config::ValidationResult(const std::string&)>;
     using ProcessorFunc = std::function<std::string(const std::string&)>;
 
@@ -112,17 +125,23 @@ void CommandHandler::SetReconnectCallback(std::function<void()> callback) {
 }
 
 int CommandHandler::ConnectAutoProfiles() {
-    int connected = 0;
+    int connected = 0, onDemand = 0;
     for (int i = 0; i < Config::isize(m_sessions); i++) {
         if (m_sessions[i].config.autoConnect &&
             !m_sessions[i].config.host.empty() &&
             !m_sessions[i].config.key.empty()) {
+            if (m_sessions[i].config.onDemand) {
+                PrepareSession(i);
+                if (m_sessions[i].connection) onDemand++;
+                continue;
+            }
             ConnectSession(i);
             if (m_sessions[i].connection && m_sessions[i].connection->IsConnected()) {
                 connected++;
             }
         }
     }
+    if (onDemand) std::cout << onDemand << " profile(s) will connect when selected" << std::endl;
     RebuildShortcuts();
     return connected;
 }
@@ -141,7 +160,7 @@ bool CommandHandler::HasAnyConnected() const {
 
 bool CommandHandler::HasDisconnectedSessions() const {
     for (const auto& s : m_sessions) {
-        if (s.connection && !s.connection->IsConnected()) return true;
+        if (s.connection && !s.connection->IsConnected() && !s.connection->IsHibernating()) return true;
     }
     return false;
 }
@@ -203,6 +222,18 @@ bool CommandHandler::ConnectInteractive() {
     return true;
 }
 
+std::unique_ptr<ConnectionManager> CommandHandler::CreateConnection(const ProfileConfig& p) {
+    auto connection = std::make_unique<ConnectionManager>();
+    connection->ApplyProfileConfig(p);
+    if (m_disconnectCallback) {
+        connection->SetDisconnectCallback(m_disconnectCallback);
+    }
+    if (m_reconnectCallback) {
+        connection->SetReconnectCallback(m_reconnectCallback);
+    }
+    return connection;
+}
+
 void CommandHandler::ConnectSession(int index) {
     if (!IsValidSessionIndex(index)) return;
     auto& session = m_sessions[index];
@@ -210,6 +241,11 @@ void CommandHandler::ConnectSession(int index) {
     if (session.connection && session.connection->IsConnected()) {
         return;
     }
+    if (session.connection && session.connection->IsHibernating()) {
+        std::cout << "Waking " << session.config.name << std::endl;
+        session.connection->Wake();
+        return;
+    }
 
     const auto& p = session.config;
     if (p.host.empty() || p.key.empty()) {
@@ -219,15 +255,8 @@ void CommandHandler::ConnectSession(int index) {
 
     std::cout << "Connecting to " << p.name << " (" << p.host << ":" << p.port << ")..." << std::endl;
 
-    session.connection = std::make_unique<ConnectionManager>();
-    session.connection->ApplyProfileConfig(p);
-    if (m_disconnectCallback) {
-        session.connection->SetDisconnectCallback(m_disconnectCallback);
-    }
-    if (m_reconnectCallback) {
-        session.connection->SetReconnectCallback(m_reconnectCallback);
-    }
-
+    ClearWakeTargets();
+    session.connection = CreateConnection(p);
     if (session.connection->EstablishConnection(p.host, p.port, p.key, p.shortcut)) {
         std::cout << "Connected to " << p.name << std::endl;
     } else {
@@ -236,12 +265,27 @@ void CommandHandler::ConnectSession(int index) {
     }
 }
 
+// The session gets a hibernating connection: it is routed like a connected
+// one, and connects when AppState selects it.
+void CommandHandler::PrepareSession(int index) {
+    if (!IsValidSessionIndex(index)) return;
+    auto& session = m_sessions[index];
+    const auto& p = session.config;
+    ClearWakeTargets();
+    session.connection = CreateConnection(p);
+    if (!session.connection->PrepareConnection(p.host, p.port, p.key, p.shortcut)) {
+        std::cerr << "Invalid connection settings for " << p.name << std::endl;
+        session.connection.reset();
+    }
+}
+
 void CommandHandler::DisconnectSession(int index) {
     if (!IsValidSessionIndex(index)) return;
     auto& session = m_sessions[index];
     if (session.connection) {
         std::cout << "Disconnecting " << session.config.name << "..." << std::endl;
         session.connection->SetDisconnectCallback(nullptr);
+        ClearWakeTargets();
         session.connection.reset();
         std::cout << "Disconnected " << session.config.name << std::endl;
     }
@@ -252,10 +296,12 @@ void CommandHandler::RebuildShortcuts() {
     int shortcutIdx = 0;
     std::vector<int> connectedIndices;
     std::vector<std::string> connectedNames;
+    std::vector<int> broadcastIndices;
+    std::vector<std::pair<int, ConnectionManager*>> wakeTargets;
 
     for (int i = 0; i < Config::isize(m_sessions); i++) {
         auto& session = m_sessions[i];
-        if (session.connection && session.connection->IsConnected()) {
+        if (session.connection && (session.connection->IsConnected() || session.config.onDemand)) {
             if (!session.config.shortcut.empty()) {
                 KeyboardState::SetToggleShortcutAt(shortcutIdx, session.config.shortcut);
             }
@@ -264,13 +310,20 @@ void CommandHandler::RebuildShortcuts() {
             session.shortcutIndex = shortcutIdx;
             connectedIndices.push_back(shortcutIdx);
             connectedNames.push_back(session.config.name);
+            if (session.config.broadcast) broadcastIndices.push_back(shortcutIdx);
+            if (session.config.onDemand) wakeTargets.emplace_back(shortcutIdx, session.connection.get());
             shortcutIdx++;
         } else {
             session.shortcutIndex = -1;
         }
     }
 
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_wakeTargets = std::move(wakeTargets);
+    }
     AppState::SetConnectedProfiles(connectedIndices, connectedNames);
+    AppState::SetBroadcastProfiles(broadcastIndices.empty() ? connectedIndices : broadcastIndices);
 }
 
 void CommandHandler::UpdateNetworkClients() {
@@ -292,14 +345,43 @@ void CommandHandler::ToggleProfile(int index) {
     RebuildShortcuts();
 }
 
+void CommandHandler::ClearWakeTargets() {
+    std::lock_guard<std::mutex> lock(m_wakeMutex);
+    m_wakeTargets.clear();
+}
+
+// Holds m_wakeMutex while waking, so a connection cannot be destroyed under
+// it. Wake only signals the reconnect thread and never blocks.
+void CommandHandler::WakeProfile(int profileIndex, int nextProfileIndex) {
+    std::lock_guard<std::mutex> lock(m_wakeMutex);
+    for (const auto& [shortcutIndex, connection] : m_wakeTargets) {
+        if (shortcutIndex == profileIndex) connection->Wake();
+        else if (shortcutIndex == nextProfileIndex) connection->Wake(false);
+    }
+}
+
 void CommandHandler::ReconnectAll() {
     for (int i = 0; i < Config::isize(m_sessions); i++) {
         DisconnectSession(i);
-        ConnectSession(i);
+        if (m_sessions[i].config.onDemand) PrepareSession(i);
+        else ConnectSession(i);
     }
     RebuildShortcuts();
 }
 
+bool CommandHandler::Shutdown() {
+    ClearWakeTargets();
+    std::vector<std::unique_ptr<ConnectionManager>> connections;
+    for (auto& session : m_sessions) {
+        if (!session.connection) continue;
+        session.connection->SetDisconnectCallback(nullptr);
+        session.shortcutIndex = -1;
+        connections.push_back(std::move(session.connection));
+    }
+    return ConnectionManager::ShutdownAll(std::move(connections),
+                                          std::chrono::milliseconds(Config::SHUTDOWN_DEADLINE_MS));
+}
+
 void CommandHandler::RunCommandLoop() {
     std::string line;
     std::cout << "> " << std::flush;
@@ -374,12 +456,42 @@ void CommandHandler::CmdStatus() {
     for (int i = 0; i < total; i++) {
         const auto& s = m_sessions[i];
         bool isConnected = s.connection && s.connection->IsConnected();
+        bool isIdle = s.connection && s.connection->IsHibernating();
         std::cout << "  [" << i << "] " << s.config.name
                   << " - " << s.config.host << ":" << s.config.port
-                  << " - " << (isConnected ? "CONNECTED" : "DISCONNECTED")
+                  << " - " << (isConnected ? "CONNECTED" : isIdle ? "IDLE" : "DISCONNECTED")
                   << (s.config.autoConnect ? "" : " (manual)")
+                  << (s.config.onDemand ? " (on demand)" : "")
                   << std::endl;
+        if (isConnected) {
+            auto q = s.connection->GetClient()->GetSendQueueStats();
+            std::cout << "      send queue: " << q.depth << " queued (" << q.bytes << " bytes)"
+                      << ", peak " << q.highWaterMessages << " (" << q.highWaterBytes << " bytes)";
+            if (q.dropped || q.collapsed || q.refused) {
+                std::cout << ", dropped " << q.dropped << ", collapsed " << q.collapsed
+                          << ", refused " << q.refused;
+            }
+            std::cout << std::endl;
+            auto tls = s.connection->GetClient()->GetTlsInfo();
+            std::cout << "      tls: " << tls.version << " " << tls.ciphersuite
+                      << ", records in " << tls.maxInRecord << ", out " << tls.maxOutRecord << " bytes" << std::endl;
+        }
     }
+
+    auto sq = SpeechQueue::GetStats();
+    std::cout << "Speech queue: " << sq.depth << " queued, peak " << sq.peakDepth
+              << ", " << sq.spoken << " spoken, " << sq.merged << " merged, " << sq.cancelled << " cancelled"
+              << std::fixed << std::setprecision(1)
+              << ", latency avg " << sq.avgLatencyMs << " ms, max " << sq.maxLatencyMs << " ms"
+              << std::defaultfloat << std::endl;
+
+    auto dns = DnsCache::GetStats();
+    std::cout << "DNS cache: " << dns.entries << " hosts, " << dns.hits << " hits, " << dns.staleHits
+              << " stale hits, " << dns.misses << " misses"
+              << std::fixed << std::setprecision(0) << " (" << dns.hitRate * 100.0 << "% hit rate)"
+              << std::defaultfloat << ", " << dns.refreshes << " refreshes";
+    if (dns.refreshFailures) std::cout << ", " << dns.refreshFailures << " failed";
+    std::cout << std::endl;
 }
 
 void CommandHandler::CmdList() {
@@ -397,6 +509,14 @@ void CommandHandler::CmdList() {
                   << " | speech=" << (p.speech ? "yes" : "no")
                   << " | mute_on_local_control=" << (p.muteOnLocalControl ? "yes" : "no")
                   << " | forward_nvda_sounds=" << (p.forwardAudio ? "yes" : "no")
+                  << " | broadcast=" << (p.broadcast ? "yes" : "no")
+                  << " | send_queue_limit=" << p.sendQueueLimit
+                  << " | clipboard_when_full=" << p.clipboardWhenFull
+                  << " | timeouts(ms) dns=" << p.dnsTimeoutMs << " tcp=" << p.tcpTimeoutMs
+                  << " tls=" << p.tlsTimeoutMs << " join=" << p.joinTimeoutMs
+                  << " | early_data=" << (p.earlyData ? "yes" : "no")
+                  << " | on_demand=" << (p.onDemand ? "yes" : "no")
+                  << " idle_timeout_ms=" << p.idleTimeoutMs
                   << std::endl;
     }
 }
@@ -586,7 +706,7 @@ void CommandHandler::CmdEdit(const std::string& args) {
 
     if (target.empty() || field.empty() || value.empty()) {
         std::cout << "Usage: edit <name or index> <field> <value>" << std::endl;
-        std::cout << "Fields: name, host, port, key, shortcut, auto_connect, speech, mute_on_local_control, forward_nvda_sounds" << std::endl;
+        std::cout << "Fields: name, host, port, key, shortcut, auto_connect, speech, mute_on_local_control, forward_nvda_sounds, broadcast, send_queue_limit, clipboard_when_full, dns_timeout_ms, tcp_timeout_ms, tls_timeout_ms, join_timeout_ms, early_data, on_demand, idle_timeout_ms" << std::endl;
         return;
     }
 
@@ -628,6 +748,50 @@ void CommandHandler::CmdEdit(const std::string& args) {
             if (s.connection) s.connection->SetForwardAudioEnabled(s.config.forwardAudio);
             return true;
         }},
+        {"broadcast", [](ProfileSession& s, const std::string& v) {
+            s.config.broadcast = Config::StringToBool(v);
+            return true;
+        }},
+        {"send_queue_limit", [](ProfileSession& s, const std::string& v) {
+            try { s.config.sendQueueLimit = std::stoi(v); }
+            catch (...) { std::cout << "Invalid queue limit" << std::endl; return false; }
+            if (s.connection) s.connection->ApplySendQueueLimits(s.config);
+            return true;
+        }},
+        {"clipboard_when_full", [](ProfileSession& s, const std::string& v) {
+            if (v != "refuse" && v != "block") {
+                std::cout << "clipboard_when_full must be 'refuse' or 'block'" << std::endl;
+                return false;
+            }
+            s.config.clipboardWhenFull = v;
+            if (s.connection) s.connection->ApplySendQueueLimits(s.config);
+            return true;
+        }},
+        {"dns_timeout_ms",  TimeoutApplier(&ProfileConfig::dnsTimeoutMs)},
+        {"tcp_timeout_ms",  TimeoutApplier(&ProfileConfig::tcpTimeoutMs)},
+        {"tls_timeout_ms",  TimeoutApplier(&ProfileConfig::tlsTimeoutMs)},
+        {"join_timeout_ms", TimeoutApplier(&ProfileConfig::joinTimeoutMs)},
+        {"early_data", [](ProfileSession& s, const std::string& v) {
+            s.config.earlyData = Config::StringToBool(v);
+#ifdef NVDAREMOTE_TLS_LOW_MEMORY
+            if (s.config.earlyData) {
+                std::cout << "early_data uses TLS 1.3, so this profile will not get small TLS records" << std::endl;
+            }
+#endif
+            if (s.connection) s.connection->SetEarlyDataEnabled(s.config.earlyData);
+            return true;
+        }},
+        {"on_demand", [](ProfileSession& s, const std::string& v) {
+            s.config.onDemand = Config::StringToBool(v);
+            if (s.connection) s.connection->ApplyOnDemand(s.config);
+            return true;
+        }},
+        {"idle_timeout_ms", [](ProfileSession& s, const std::string& v) {
+            try { s.config.idleTimeoutMs = std::stoi(v); }
+            catch (...) { std::cout << "Invalid timeout" << std::endl; return false; }
+            if (s.connection) s.connection->ApplyOnDemand(s.config);
+            return true;
+        }},
     };
 
     auto it = fieldAppliers.find(field);
@@ -636,6 +800,7 @@ void CommandHandler::CmdEdit(const std::string& args) {
         return;
     }
     if (!it->second(session, value)) return;
+    if (field == "broadcast" || field == "on_demand") RebuildShortcuts();
 
     if (idx < Config::isize(m_configData.profiles)) {
         m_configData.profiles[idx] = p;
@@ -748,8 +913,20 @@ void CommandHandler::CmdClip() {
         std::cout << "Clipboard is empty." << std::endl;
         return;
     }
-    MessageSender::SendClipboardText(text);
-    std::cout << "Clipboard sent to remote." << std::endl;
+    switch (MessageSender::SendClipboardText(text)) {
+        case ClipboardSendResult::Sent:
+            std::cout << "Clipboard sent to remote." << std::endl;
+            break;
+        case ClipboardSendResult::Streaming:
+            std::cout << "Sending " << text.size() << " bytes of clipboard text to remote." << std::endl;
+            break;
+        case ClipboardSendResult::TooLarge:
+            std::cout << "Clipboard too large (limit " << Config::MAX_CLIPBOARD_BYTES / 1024 << " KB)." << std::endl;
+            break;
+        case ClipboardSendResult::NotSent:
+            std::cout << "Clipboard not sent." << std::endl;
+            break;
+    }
 }
 
 void CommandHandler::CmdReinstallHook() {
@@ -7,6 +7,8 @@
 #include <string>
 #include <functional>
 #include <atomic>
+#include <mutex>
+#include <utility>
 
 extern std::atomic<bool> g_shutdown;
 
@@ -33,7 +35,10 @@ public:
     int GetSessionCount() const { return Config::isize(m_sessions); }
 
     void ReconnectAll();
+    bool Shutdown();
     void ToggleProfile(int index);
+    // Wakes the selected on-demand profile and pre-warms the next one.
+    void WakeProfile(int profileIndex, int nextProfileIndex);
     void UpdateNetworkClients();
     void SetDisconnectCallback(std::function<void()> callback);
     void SetReconnectCallback(std::function<void()> callback);
@@ -63,13 +68,21 @@ private:
 
     void AppendProfile(const ProfileConfig& p);
     void SaveConfig();
+    std::unique_ptr<ConnectionManager> CreateConnection(const ProfileConfig& p);
     void ConnectSession(int index);
+    void PrepareSession(int index);
     void DisconnectSession(int index);
     void RebuildShortcuts();
+    void ClearWakeTargets();
 
     std::string m_configPath;
     ConfigFileData m_configData;
     std::vector<ProfileSession> m_sessions;
+    // On-demand connections by shortcut index. WakeProfile runs on the
+    // keyboard thread and only looks here; entries are removed before the
+    // command thread replaces or destroys their connection.
+    std::mutex m_wakeMutex;
+    std::vector<std::pair<int, ConnectionManager*>> m_wakeTargets;
     std::function<void()> m_disconnectCallback;
     std::function<void()> m_reconnectCallback;
 };
@@ -19,10 +19,22 @@ namespace Config {
     constexpr int MAX_PORT = 65535;
     constexpr int HANDSHAKE_TIMEOUT_MS = 3000;
     constexpr int HANDSHAKE_RETRY_INTERVAL_MS = 30;
-    constexpr int HANDSHAKE_MAX_ATTEMPTS = 100;
     
     constexpr int RECEIVER_BUFFER_SIZE = 4096;
     constexpr int SENDER_SLEEP_MS = 1;
+    constexpr int SEND_POLL_INTERVAL_MS = 50;
+    constexpr int SEND_STALL_TIMEOUT_MS = 10000;
+    constexpr int SHUTDOWN_DEADLINE_MS = 3000;
+
+    constexpr int DNS_TIMEOUT_MS = 5000;
+    constexpr int TCP_CONNECT_TIMEOUT_MS = 5000;
+    constexpr int TLS_HANDSHAKE_TIMEOUT_MS = 5000;
+    constexpr int MIN_CONNECT_PHASE_TIMEOUT_MS = 100;
+    constexpr int CONNECT_POLL_INTERVAL_MS = 50;
+    constexpr int CONNECT_ATTEMPT_DELAY_MS = 250;
+    constexpr int DNS_CACHE_TTL_MS = 5 * 60 * 1000;
+    constexpr int DNS_CACHE_MAX_STALE_MS = 24 * 60 * 60 * 1000;
+    constexpr int IDLE_TIMEOUT_MS = 10 * 60 * 1000;
     
     constexpr int PROTOCOL_VERSION = 2;
     constexpr const char* DEFAULT_CONNECTION_TYPE = "master";
@@ -33,7 +45,19 @@ namespace Config {
     
     constexpr size_t MAX_HOST_LENGTH = 253;
     constexpr size_t MAX_KEY_LENGTH = 256;
-    constexpr size_t MAX_MESSAGE_SIZE = 8192;
+    // Large enough for a MAX_CLIPBOARD_BYTES clipboard after the peer's
+    // \uXXXX escaping of non-ASCII text.
+    constexpr size_t MAX_MESSAGE_SIZE = 2 * 1024 * 1024;
+    constexpr size_t RECEIVE_BUFFER_KEEP_BYTES = 64 * 1024;
+
+    constexpr size_t SEND_QUEUE_MAX_MESSAGES = 256;
+    constexpr int SEND_QUEUE_MIN_MESSAGES = 16;
+    constexpr size_t SEND_QUEUE_MAX_BYTES = 1024 * 1024;
+    constexpr int SEND_QUEUE_BLOCK_TIMEOUT_MS = 2000;
+
+    constexpr size_t MAX_CLIPBOARD_BYTES = 512 * 1024;
+    constexpr size_t CLIPBOARD_CHUNK_BYTES = 16 * 1024;
+    constexpr size_t CLIPBOARD_PROGRESS_BYTES = 128 * 1024;
     
     constexpr const char* APP_NAME = "NVDA Remote Client";
     constexpr const char* APP_DESCRIPTION = "Cross-platform client for NVDA Remote connections";
@@ -110,6 +110,16 @@ static nlohmann::ordered_json SerializeProfile(const ProfileConfig& p) {
     j[ProfileFields::SPEECH]               = p.speech;
     j[ProfileFields::MUTE_ON_LOCAL_CONTROL] = p.muteOnLocalControl;
     j[ProfileFields::FORWARD_AUDIO]         = p.forwardAudio;
+    j[ProfileFields::BROADCAST]             = p.broadcast;
+    j[ProfileFields::SEND_QUEUE_LIMIT]      = p.sendQueueLimit;
+    j[ProfileFields::CLIPBOARD_WHEN_FULL]   = p.clipboardWhenFull;
+    j[ProfileFields::DNS_TIMEOUT_MS]        = p.dnsTimeoutMs;
+    j[ProfileFields::TCP_TIMEOUT_MS]        = p.tcpTimeoutMs;
+    j[ProfileFields::TLS_TIMEOUT_MS]        = p.tlsTimeoutMs;
+    j[ProfileFields::JOIN_TIMEOUT_MS]       = p.joinTimeoutMs;
+    j[ProfileFields::EARLY_DATA]            = p.earlyData;
+    j[ProfileFields::ON_DEMAND]             = p.onDemand;
+    j[ProfileFields::IDLE_TIMEOUT_MS]       = p.idleTimeoutMs;
     return j;
 }
 
@@ -124,6 +134,16 @@ static ProfileConfig ParseProfile(const nlohmann::json& j) {
     ReadJson(j, ProfileFields::SPEECH,               p.speech);
     ReadJson(j, ProfileFields::MUTE_ON_LOCAL_CONTROL, p.muteOnLocalControl);
     ReadJson(j, ProfileFields::FORWARD_AUDIO,         p.forwardAudio);
+    ReadJson(j, ProfileFields::BROADCAST,             p.broadcast);
+    ReadJson(j, ProfileFields::SEND_QUEUE_LIMIT,      p.sendQueueLimit);
+    ReadJson(j, ProfileFields::CLIPBOARD_WHEN_FULL,   p.clipboardWhenFull);
+    ReadJson(j, ProfileFields::DNS_TIMEOUT_MS,        p.dnsTimeoutMs);
+    ReadJson(j, ProfileFields::TCP_TIMEOUT_MS,        p.tcpTimeoutMs);
+    ReadJson(j, ProfileFields::TLS_TIMEOUT_MS,        p.tlsTimeoutMs);
+    ReadJson(j, ProfileFields::JOIN_TIMEOUT_MS,       p.joinTimeoutMs);
+    ReadJson(j, ProfileFields::EARLY_DATA,            p.earlyData);
+    ReadJson(j, ProfileFields::ON_DEMAND,             p.onDemand);
+    ReadJson(j, ProfileFields::IDLE_TIMEOUT_MS,       p.idleTimeoutMs);
     return p;
 }
 
@@ -153,8 +173,10 @@ bool ConfigFile::Migrate(const std::string& path) {
     try { j = nlohmann::json::parse(in); }
     catch (...) { return false; }
     in.close();
+    if (!j.is_object()) return false;
 
-    int version = j.value("schema_version", 0);
+    auto versionField = j.find("schema_version");
+    int version = versionField != j.end() && versionField->is_number_integer() ? versionField->get<int>() : 0;
     if (version >= CURRENT_SCHEMA_VERSION) return false;
 
     if (version < 1) { Migrate_0_to_1(j); version = 1; }
@@ -175,6 +197,7 @@ static ConfigFileData ParseConfigJson(const nlohmann::json& j) {
     ReadJson(j, "debug_level", data.debugLevel);
     ReadJson(j, "background",  data.background);
     ReadJson(j, "audio",       data.audio);
+    ReadJson(j, "cipher_preference", data.cipherPreference);
 
     if (j.contains("shortcuts") && j["shortcuts"].is_object()) {
         const auto& sc = j["shortcuts"];
@@ -184,6 +207,7 @@ static ConfigFileData ParseConfigJson(const nlohmann::json& j) {
         ReadJson(sc, "reconnect",      data.reconnectShortcut);
         ReadJson(sc, "clipboard",      data.clipboardShortcut);
         ReadJson(sc, "forward_keys",   data.forwardKeysShortcut);
+        ReadJson(sc, "broadcast",      data.broadcastShortcut);
     }
 
     if (j.contains("profiles") && j["profiles"].is_array()) {
@@ -255,7 +279,17 @@ bool ConfigFile::CreateDefault(const std::string& path) {
         {"auto_connect",         true},
         {"speech",               true},
         {"mute_on_local_control", false},
-        {"forward_nvda_sounds",  true}
+        {"forward_nvda_sounds",  true},
+        {"broadcast",            false},
+        {"send_queue_limit",     static_cast<int>(Config::SEND_QUEUE_MAX_MESSAGES)},
+        {"clipboard_when_full",  "refuse"},
+        {"dns_timeout_ms",       Config::DNS_TIMEOUT_MS},
+        {"tcp_timeout_ms",       Config::TCP_CONNECT_TIMEOUT_MS},
+        {"tls_timeout_ms",       Config::TLS_HANDSHAKE_TIMEOUT_MS},
+        {"join_timeout_ms",      Config::HANDSHAKE_TIMEOUT_MS},
+        {"early_data",           false},
+        {"on_demand",            false},
+        {"idle_timeout_ms",      Config::IDLE_TIMEOUT_MS}
     };
 
     nlohmann::ordered_json j = {
@@ -263,13 +297,15 @@ bool ConfigFile::CreateDefault(const std::string& path) {
         {"debug_level",    "warning"},
         {"background",     false},
         {"audio",          true},
+        {"cipher_preference", "auto"},
         {"shortcuts", nlohmann::ordered_json({
             {"cycle",          Config::DEFAULT_CYCLE_SHORTCUT},
             {"exit",           ""},
             {"reinstall_hook", ""},
             {"reconnect",      ""},
             {"clipboard",      ""},
-            {"forward_keys",   Config::DEFAULT_FORWARD_KEYS_SHORTCUT}
+            {"forward_keys",   Config::DEFAULT_FORWARD_KEYS_SHORTCUT},
+            {"broadcast",      ""}
         })},
         {"profiles", nlohmann::ordered_json::array({profile})}
     };
@@ -288,6 +324,7 @@ bool ConfigFile::Save(const std::string& path, const ConfigFileData& data) {
     j["debug_level"] = data.debugLevel.value_or("warning");
     j["background"] = data.background.value_or(false);
     j["audio"] = data.audio.value_or(true);
+    if (data.cipherPreference) j["cipher_preference"] = *data.cipherPreference;
     {
         nlohmann::ordered_json sc;
         sc["cycle"] = data.cycleShortcut.value_or(Config::DEFAULT_CYCLE_SHORTCUT);
@@ -296,6 +333,7 @@ bool ConfigFile::Save(const std::string& path, const ConfigFileData& data) {
         if (data.reconnectShortcut)      sc["reconnect"]      = *data.reconnectShortcut;
         if (data.clipboardShortcut)      sc["clipboard"]      = *data.clipboardShortcut;
         sc["forward_keys"] = data.forwardKeysShortcut.value_or(Config::DEFAULT_FORWARD_KEYS_SHORTCUT);
+        if (data.broadcastShortcut)      sc["broadcast"]      = *data.broadcastShortcut;
         j["shortcuts"] = std::move(sc);
     }
 
@@ -2,6 +2,7 @@
 #include <string>
 #include <optional>
 #include <vector>
+#include "Config.h"
 
 namespace ProfileFields {
     constexpr const char* NAME                  = "name";
@@ -13,6 +14,16 @@ namespace ProfileFields {
     constexpr const char* SPEECH                = "speech";
     constexpr const char* MUTE_ON_LOCAL_CONTROL = "mute_on_local_control";
     constexpr const char* FORWARD_AUDIO         = "forward_nvda_sounds";
+    constexpr const char* BROADCAST             = "broadcast";
+    constexpr const char* SEND_QUEUE_LIMIT      = "send_queue_limit";
+    constexpr const char* CLIPBOARD_WHEN_FULL   = "clipboard_when_full";
+    constexpr const char* DNS_TIMEOUT_MS        = "dns_timeout_ms";
+    constexpr const char* TCP_TIMEOUT_MS        = "tcp_timeout_ms";
+    constexpr const char* TLS_TIMEOUT_MS        = "tls_timeout_ms";
+    constexpr const char* JOIN_TIMEOUT_MS       = "join_timeout_ms";
+    constexpr const char* EARLY_DATA            = "early_data";
+    constexpr const char* ON_DEMAND             = "on_demand";
+    constexpr const char* IDLE_TIMEOUT_MS       = "idle_timeout_ms";
 }
 
 struct ProfileConfig {
@@ -25,18 +36,30 @@ struct ProfileConfig {
     bool speech = true;
     bool muteOnLocalControl = false;
     bool forwardAudio = true;
+    bool broadcast = false;
+    int sendQueueLimit = static_cast<int>(Config::SEND_QUEUE_MAX_MESSAGES);
+    std::string clipboardWhenFull = "refuse";
+    int dnsTimeoutMs = Config::DNS_TIMEOUT_MS;
+    int tcpTimeoutMs = Config::TCP_CONNECT_TIMEOUT_MS;
+    int tlsTimeoutMs = Config::TLS_HANDSHAKE_TIMEOUT_MS;
+    int joinTimeoutMs = Config::HANDSHAKE_TIMEOUT_MS;
+    bool earlyData = false;
+    bool onDemand = false;
+    int idleTimeoutMs = Config::IDLE_TIMEOUT_MS;
 };
 
 struct ConfigFileData {
     std::optional<std::string> debugLevel;
     std::optional<bool> background;
     std::optional<bool> audio;
+    std::optional<std::string> cipherPreference;
     std::optional<std::string> cycleShortcut;
     std::optional<std::string> exitShortcut;
     std::optional<std::string> reinstallHookShortcut;
     std::optional<std::string> reconnectShortcut;
     std::optional<std::string> clipboardShortcut;
     std::optional<std::string> forwardKeysShortcut;
+    std::optional<std::string> broadcastShortcut;
 
     std::vector<ProfileConfig> profiles;
 
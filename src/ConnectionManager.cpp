@@ -1,17 +1,17 @@
 #include "ConnectionManager.h"
 #include "Debug.h"
 #include "Speech.h"
+#include "SpeechQueue.h"
 #include "Audio.h"
 #include "Clipboard.h"
 #include "Config.h"
-#ifdef _WIN32
 #include "AppState.h"
-#endif
 #include <iostream>
 #include <thread>
 #include <chrono>
 #include <functional>
 #include <unordered_map>
+#include <algorithm>
 
 extern std::atomic<bool> g_shutdown;
 
@@ -23,11 +23,7 @@ ConnectionManager::ConnectionManager() : m_protocolHandshakeComplete(false) {
 
 ConnectionManager::~ConnectionManager() {
     DEBUG_INFO("CONN", "ConnectionManager destructor called");
-    m_wantsConnection = false;
-    {
-        std::lock_guard<std::mutex> lock(m_reconnectMutex);
-        m_reconnectCv.notify_all();
-    }
+    RequestShutdown();
     if (m_reconnectThread.joinable()) m_reconnectThread.join();
 
     if (m_client) {
@@ -41,6 +37,93 @@ ConnectionManager::~ConnectionManager() {
     DEBUG_INFO("CONN", "ConnectionManager destructor completed");
 }
 
+void ConnectionManager::RequestShutdown() {
+    m_shuttingDown = true;
+    m_wantsConnection = false;
+    std::lock_guard<std::mutex> lock(m_reconnectMutex);
+    m_reconnectCv.notify_all();
+}
+
+bool ConnectionManager::ShutdownAll(std::vector<std::unique_ptr<ConnectionManager>> managers,
+                                    std::chrono::milliseconds deadline) {
+    auto until = std::chrono::steady_clock::now() + deadline;
+    for (auto& manager : managers) {
+        if (manager) manager->RequestShutdown();
+    }
+
+    struct Pending {
+        std::mutex mutex;
+        std::condition_variable cv;
+        size_t remaining = 0;
+    };
+    auto pending = std::make_shared<Pending>();
+    std::vector<std::thread> workers;
+    for (auto& manager : managers) {
+        if (!manager) continue;
+        pending->remaining++;
+        workers.emplace_back([pending, manager = std::move(manager)]() mutable {
+            manager.reset();
+            std::lock_guard<std::mutex> lock(pending->mutex);
+            if (--pending->remaining == 0) pending->cv.notify_all();
+        });
+    }
+
+    bool finished;
+    size_t stragglers;
+    {
+        std::unique_lock<std::mutex> lock(pending->mutex);
+        finished = pending->cv.wait_until(lock, until, [&] { return pending->remaining == 0; });
+        stragglers = pending->remaining;
+    }
+    for (auto& worker : workers) {
+        if (finished) worker.join();
+        else worker.detach();
+    }
+
+    if (finished) {
+        DEBUG_INFO_F("CONN", "Closed {} connection(s)", workers.size());
+    } else {
+        DEBUG_WARN_F("CONN", "Shutdown deadline passed with {} of {} connection(s) still closing",
+                     stragglers, workers.size());
+    }
+    return finished;
+}
+
+void ConnectionManager::ApplySendQueueLimits(const ProfileConfig& p) {
+    SendQueueLimits limits;
+    limits.maxMessages = static_cast<size_t>(std::max(p.sendQueueLimit, Config::SEND_QUEUE_MIN_MESSAGES));
+    limits.clipboardPolicy = p.clipboardWhenFull == "block" ? OverflowPolicy::Block : OverflowPolicy::Refuse;
+    m_client->SetSendQueueLimits(limits);
+}
+
+void ConnectionManager::ApplyConnectTimeouts(const ProfileConfig& p) {
+    auto clamp = [](int ms) { return std::max(ms, Config::MIN_CONNECT_PHASE_TIMEOUT_MS); };
+    std::lock_guard<std::mutex> lock(m_reconnectMutex);
+    m_timeouts.dnsMs = clamp(p.dnsTimeoutMs);
+    m_timeouts.tcpMs = clamp(p.tcpTimeoutMs);
+    m_timeouts.tlsMs = clamp(p.tlsTimeoutMs);
+    m_timeouts.joinMs = clamp(p.joinTimeoutMs);
+}
+
+void ConnectionManager::SetEarlyDataEnabled(bool enabled) {
+    m_earlyData = enabled;
+#ifdef NVDAREMOTE_TLS_LOW_MEMORY
+    if (enabled) DEBUG_WARN("CONN", "early_data needs TLS 1.3, so this profile keeps full-size TLS records");
+#endif
+    m_client->SetTls13(enabled);
+    m_client->SetTlsResumption(m_earlyData || m_onDemand);
+}
+
+// On-demand profiles keep their TLS session, so waking one resumes it
+// instead of running a full handshake.
+void ConnectionManager::ApplyOnDemand(const ProfileConfig& p) {
+    m_onDemand = p.onDemand;
+    m_client->SetTlsResumption(m_earlyData || m_onDemand);
+    std::lock_guard<std::mutex> lock(m_reconnectMutex);
+    m_idleTimeoutMs = p.onDemand ? std::max(p.idleTimeoutMs, 0) : 0;
+    m_reconnectCv.notify_all();
+}
+
 bool ConnectionManager::ShouldPlaySpeech() const {
     if (!m_speechEnabled) return false;
 #ifdef _WIN32
@@ -51,10 +134,31 @@ bool ConnectionManager::ShouldPlaySpeech() const {
     return true;
 }
 
+// Item strings are read by reference and written once into a buffer that
+// keeps its capacity between messages.
+std::string_view ConnectionManager::JoinSpeechSequence(const json& sequence) {
+    size_t totalLength = 0;
+    for (const auto& item : sequence) {
+        if (item.is_string()) totalLength += item.get_ref<const std::string&>().size() + 1;
+    }
+
+    thread_local std::string speechText;
+    speechText.clear();
+    speechText.reserve(totalLength);
+    for (const auto& item : sequence) {
+        if (!item.is_string()) continue;
+        const auto& text = item.get_ref<const std::string&>();
+        if (text.empty()) continue;
+        if (!speechText.empty()) speechText += ' ';
+        speechText += text;
+    }
+    return speechText;
+}
+
 void ConnectionManager::HandleIncomingMessage(std::string_view message) {
     json j = json::parse(message, nullptr, false);
-    if (j.is_null()) {
-        DEBUG_ERROR("CONN", "Failed to parse incoming message as JSON");
+    if (!j.is_object()) {
+        DEBUG_ERROR("CONN", "Incoming message is not a JSON object");
         return;
     }
 
@@ -66,14 +170,16 @@ void ConnectionManager::HandleIncomingMessage(std::string_view message) {
             if (self.m_client) {
                 self.m_client->SendBrailleInfo();
                 self.m_protocolHandshakeComplete = true;
-                Audio::PlayWave("connected");
-                Speech::Speak("Connected", false);
+                if (self.m_announceJoin) {
+                    Audio::PlayWave("connected");
+                    Speech::Speak("Connected", false);
+                }
                 DEBUG_INFO("CONN", "Protocol handshake complete");
             }
         }},
         {Config::MSG_TYPE_CANCEL, [](ConnectionManager& self, const json&) {
             DEBUG_VERBOSE("CONN", "Received speech cancel request");
-            if (self.ShouldPlaySpeech()) Speech::Stop();
+            if (self.ShouldPlaySpeech()) SpeechQueue::Cancel();
         }},
         {Config::MSG_TYPE_TONE, [](ConnectionManager& self, const json& msg) {
             if (self.m_forwardAudio)
@@ -89,40 +195,49 @@ void ConnectionManager::HandleIncomingMessage(std::string_view message) {
                 DEBUG_VERBOSE("CONN", "Speech message missing or invalid sequence field");
                 return;
             }
-            std::string speechText;
-            for (const auto& item : msg["sequence"]) {
-                if (item.is_string()) {
-                    auto text = item.get<std::string>();
-                    if (!text.empty()) speechText += text + " ";
-                }
-            }
+            std::string_view speechText = JoinSpeechSequence(msg["sequence"]);
             if (speechText.empty()) {
                 DEBUG_VERBOSE("CONN", "Received empty speech sequence");
                 return;
             }
-            speechText.pop_back();
             DEBUG_VERBOSE_F("CONN", "Received speech: {}", speechText);
-            if (self.ShouldPlaySpeech()) Speech::Speak(speechText, false);
+            if (self.ShouldPlaySpeech()) SpeechQueue::Enqueue(speechText, false);
         }},
         {Config::MSG_TYPE_SET_CLIPBOARD_TEXT, [](ConnectionManager& self, const json& msg) {
             std::string text = msg.value("text", "");
             if (text.empty()) return;
+            if (text.size() > Config::MAX_CLIPBOARD_BYTES) {
+                DEBUG_WARN_F("CONN", "Ignoring {} bytes of clipboard text from remote", text.size());
+                if (self.ShouldPlaySpeech()) SpeechQueue::Enqueue("Remote clipboard too large", false);
+                return;
+            }
             DEBUG_INFO("CONN", "Received clipboard text from remote");
             Clipboard::SetText(text);
-            if (self.ShouldPlaySpeech()) Speech::Speak("Clipboard received", false);
+            if (self.ShouldPlaySpeech()) SpeechQueue::Enqueue("Clipboard received", false);
         }},
         {Config::MSG_TYPE_NVDA_NOT_CONNECTED, [](ConnectionManager& self, const json&) {
             DEBUG_INFO("CONN", "Remote NVDA is not connected");
-            if (self.ShouldPlaySpeech()) Speech::Speak("Remote NVDA is not connected", true);
+            if (self.ShouldPlaySpeech()) SpeechQueue::Enqueue("Remote NVDA is not connected", true);
         }},
     };
 
-    auto messageType = j.value("type", "");
+    auto type = j.find("type");
+    if (type == j.end() || !type->is_string()) {
+        DEBUG_VERBOSE("CONN", "Incoming message has no type");
+        return;
+    }
+    const auto& messageType = type->get_ref<const std::string&>();
     auto it = dispatch.find(messageType);
-    if (it != dispatch.end()) {
-        it->second(*this, j);
-    } else if (!messageType.empty()) {
+    if (it == dispatch.end()) {
         DEBUG_VERBOSE_F("CONN", "Unhandled message type: {}", messageType);
+        return;
+    }
+
+    // A field of the wrong type must not take the receiver thread down.
+    try {
+        it->second(*this, j);
+    } catch (const json::exception& e) {
+        DEBUG_ERROR_F("CONN", "Malformed {} message: {}", messageType, e.what());
     }
 }
 
@@ -150,6 +265,18 @@ bool ConnectionManager::PerformHandshake() {
 }
 
 bool ConnectionManager::EstablishConnection(std::string_view host, int port, std::string_view key, std::string_view shortcut) {
+    m_hibernating = false;
+    m_announceJoin = true;
+    if (!SetConnectionParams(host, port, key, shortcut)) return false;
+    return EstablishConnectionInternal();
+}
+
+bool ConnectionManager::PrepareConnection(std::string_view host, int port, std::string_view key, std::string_view shortcut) {
+    m_hibernating = true;
+    return SetConnectionParams(host, port, key, shortcut);
+}
+
+bool ConnectionManager::SetConnectionParams(std::string_view host, int port, std::string_view key, std::string_view shortcut) {
     auto sanitizedHost = Config::TrimWhitespace(std::string(host));
     auto sanitizedKey = Config::TrimWhitespace(std::string(key));
     auto sanitizedShortcut = Config::TrimWhitespace(std::string(shortcut));
@@ -172,8 +299,38 @@ bool ConnectionManager::EstablishConnection(std::string_view host, int port, std
         m_reconnectThread = std::thread(&ConnectionManager::ReconnectLoop, this);
     }
 #endif
+    return true;
+}
 
-    return EstablishConnectionInternal();
+void ConnectionManager::Wake(bool announce) {
+    if (!m_wantsConnection || IsConnected()) return;
+    std::lock_guard<std::mutex> lock(m_reconnectMutex);
+    m_announceJoin = announce;
+    m_hibernating = false;
+    m_wakePending = true;
+    m_reconnectCv.notify_all();
+}
+
+void ConnectionManager::Hibernate() {
+    if (m_hibernating.exchange(true)) return;
+    DEBUG_INFO_F("CONN", "Profile {} is idle, closing its connection until it is selected", m_profileIndex);
+    m_protocolHandshakeComplete = false;
+    if (m_client) m_client->Disconnect();
+}
+
+// Runs on the reconnect thread. Returns when to look again. The selected
+// profile and any profile receiving keys never count as idle.
+std::chrono::steady_clock::time_point ConnectionManager::CheckIdle(int idleMs) {
+    auto now = std::chrono::steady_clock::now();
+    auto idle = std::chrono::milliseconds(idleMs);
+    if (!IsConnected() || AppState::GetActiveProfile() == m_profileIndex ||
+        AppState::IsReceivingKeys(m_profileIndex)) {
+        return now + idle;
+    }
+    auto due = m_client->LastSendTime() + idle;
+    if (due > now) return due;
+    Hibernate();
+    return now + idle;
 }
 
 bool ConnectionManager::Reconnect() {
@@ -200,9 +357,26 @@ void ConnectionManager::Disconnect() {
 }
 
 bool ConnectionManager::EstablishConnectionInternal() {
+    if (m_shuttingDown) return false;
+    // Whatever the last connection left behind (worker threads, socket and
+    // TLS state) goes before a new one starts on the same client.
+    m_client->Disconnect();
     DEBUG_INFO_F("CONN", "Attempting to connect to {}:{}", m_params.host, m_params.port);
+    ConnectTimeouts timeouts;
+    {
+        std::lock_guard<std::mutex> lock(m_reconnectMutex);
+        timeouts = m_timeouts;
+    }
     
-    if (!m_client->Connect(m_params.host, m_params.port)) {
+    // With early_data the opening lines go out inside the TLS handshake,
+    // as 0-RTT data when a resumed session allows it.
+    std::string opening;
+    if (m_earlyData) {
+        opening = NetworkClient::ProtocolVersionMessage().dump() + '\n' +
+                  NetworkClient::JoinChannelMessage(m_params.key).dump() + '\n';
+    }
+
+    if (!m_client->Connect(m_params.host, m_params.port, timeouts, [this] { return !m_shuttingDown; }, opening)) {
         DEBUG_ERROR("CONN", "Failed to connect to server");
         return false;
     }
@@ -216,22 +390,25 @@ bool ConnectionManager::EstablishConnectionInternal() {
     m_client->StartReceiving();
     
     DEBUG_VERBOSE("CONN", "Performing protocol handshake");
-    if (!PerformHandshake()) {
+    if (opening.empty() && !PerformHandshake()) {
         DEBUG_ERROR("CONN", "Protocol handshake failed - cleaning up");
         m_client->Disconnect();
         return false;
     }
     
     DEBUG_VERBOSE("CONN", "Waiting for handshake to complete");
-    for (int i = 0; i < Config::HANDSHAKE_MAX_ATTEMPTS; ++i) {
+    auto joinDeadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeouts.joinMs);
+    while (!m_shuttingDown) {
         if (m_protocolHandshakeComplete) {
             DEBUG_INFO("CONN", "Connection established successfully");
             return true;
         }
+        if (std::chrono::steady_clock::now() >= joinDeadline) break;
         std::this_thread::sleep_for(std::chrono::milliseconds(Config::HANDSHAKE_RETRY_INTERVAL_MS));
     }
     
-    DEBUG_ERROR("CONN", "Handshake timeout - cleaning up");
+    DEBUG_ERROR("CONN", m_shuttingDown ? "Shutting down during handshake - cleaning up"
+                                       : "Handshake timeout - cleaning up");
     m_client->Disconnect();
     return false;
 }
@@ -243,14 +420,21 @@ bool ConnectionManager::IsConnected() const {
 void ConnectionManager::SetDisconnectCallback(std::function<void()> callback) {
     m_disconnectCallback = callback;
     if (m_client) {
-        m_client->SetDisconnectCallback([this]() {
-            m_protocolHandshakeComplete = false;
-            if (m_disconnectCallback) m_disconnectCallback();
-            TriggerReconnect();
-        });
+        m_client->SetDisconnectCallback([this]() { OnConnectionLost(); });
     }
 }
 
+void ConnectionManager::OnConnectionLost() {
+    if (m_shuttingDown || m_hibernating) return;
+    DEBUG_INFO_F("CONN", "Connection lost for profile {}", m_profileIndex);
+    m_protocolHandshakeComplete = false;
+    // Only this profile is affected: other sessions and the keyboard grab
+    // keep running while the reconnect thread brings this one back.
+    if (m_profileIndex >= 0) AppState::HandleProfileLost(m_profileIndex);
+    if (m_disconnectCallback) m_disconnectCallback();
+    TriggerReconnect();
+}
+
 void ConnectionManager::TriggerReconnect() {
     if (!m_wantsConnection) return;
     std::lock_guard<std::mutex> lock(m_reconnectMutex);
@@ -258,27 +442,69 @@ void ConnectionManager::TriggerReconnect() {
     m_reconnectCv.notify_one();
 }
 
+// Also owns the on-demand lifecycle: Wake requests are served here, and
+// with an idle timeout the loop wakes up to hibernate an unused connection.
 void ConnectionManager::ReconnectLoop() {
+    using Clock = std::chrono::steady_clock;
+    auto idleCheckAt = Clock::now();
     while (true) {
+        bool waking, reconnecting;
         {
             std::unique_lock<std::mutex> lock(m_reconnectMutex);
-            m_reconnectCv.wait(lock, [this] {
-                return m_reconnectPending || !m_wantsConnection;
-            });
+            int idleMs = m_hibernating ? 0 : m_idleTimeoutMs;
+            auto ready = [this, idleMs] {
+                return m_reconnectPending || m_wakePending || !m_wantsConnection ||
+                       (m_hibernating ? 0 : m_idleTimeoutMs) != idleMs;
+            };
+            if (idleMs <= 0) {
+                m_reconnectCv.wait(lock, ready);
+            } else if (!m_reconnectCv.wait_until(lock, idleCheckAt, ready)) {
+                lock.unlock();
+                idleCheckAt = CheckIdle(idleMs);
+                continue;
+            }
             if (!m_wantsConnection) break;
+            waking = m_wakePending;
+            reconnecting = m_reconnectPending;
+            m_wakePending = false;
             m_reconnectPending = false;
         }
 
-        while (m_wantsConnection) {
+        // The receiver thread only reports a loss. Tearing the connection
+        // down joins that thread, so it is done here rather than there.
+        if (reconnecting && !IsConnected()) m_client->Disconnect();
+
+        if (waking && !m_hibernating && !IsConnected()) {
+            DEBUG_INFO_F("CONN", "Connecting profile {} on demand", m_profileIndex);
+            if (EstablishConnectionInternal()) {
+                if (m_reconnectCallback) m_reconnectCallback();
+                continue;
+            }
+        } else if (!reconnecting || IsConnected()) {
+            continue;
+        }
+
+        auto retryStart = Clock::now();
+        while (m_wantsConnection && !m_hibernating) {
             DEBUG_INFO_F("CONN", "Auto-reconnect: waiting 5s before retrying profile {}", m_profileIndex);
             {
                 std::unique_lock<std::mutex> lock(m_reconnectMutex);
                 m_reconnectCv.wait_for(lock, std::chrono::seconds(5),
-                    [this] { return !m_wantsConnection; });
+                    [this] { return !m_wantsConnection || m_wakePending; });
+                m_wakePending = false;
+                // An unreachable on-demand profile gives up after the same
+                // idle period a connected one would be closed after.
+                if (m_idleTimeoutMs > 0 &&
+                    Clock::now() - retryStart >= std::chrono::milliseconds(m_idleTimeoutMs)) {
+                    DEBUG_INFO_F("CONN", "Auto-reconnect: profile {} idle, waiting until it is selected", m_profileIndex);
+                    m_hibernating = true;
+                }
             }
-            if (!m_wantsConnection) break;
+            if (!m_wantsConnection || m_hibernating) break;
 
             DEBUG_INFO_F("CONN", "Auto-reconnect: attempting to reconnect profile {}", m_profileIndex);
+            // Only a pre-warm connects silently; a reconnect is announced.
+            m_announceJoin = true;
             bool ok = EstablishConnectionInternal();
             if (ok) {
                 DEBUG_INFO_F("CONN", "Auto-reconnect: profile {} reconnected", m_profileIndex);
@@ -10,6 +10,8 @@
 #include <thread>
 #include <mutex>
 #include <condition_variable>
+#include <chrono>
+#include <vector>
 
 struct ConnectionParams {
     std::string host;
@@ -29,16 +31,25 @@ private:
     bool m_muteOnLocalControl = false;
     bool m_forwardAudio = true;
     int m_profileIndex = -1;
+    bool m_earlyData = false;
+    bool m_onDemand = false;
+    std::atomic<bool> m_announceJoin{true};
+    ConnectTimeouts m_timeouts;
 
     std::atomic<bool> m_wantsConnection{false};
+    std::atomic<bool> m_shuttingDown{false};
     std::thread m_reconnectThread;
     std::mutex m_reconnectMutex;
     std::condition_variable m_reconnectCv;
     bool m_reconnectPending = false;
+    bool m_wakePending = false;
+    int m_idleTimeoutMs = 0;
+    std::atomic<bool> m_hibernating{false};
 
-    void HandleIncomingMessage(std::string_view message);
+    bool SetConnectionParams(std::string_view host, int port, std::string_view key, std::string_view shortcut);
     bool PerformHandshake();
     bool EstablishConnectionInternal();
+    std::chrono::steady_clock::time_point CheckIdle(int idleMs);
     bool ShouldPlaySpeech() const;
     void TriggerReconnect();
     void ReconnectLoop();
@@ -48,8 +59,28 @@ public:
     ~ConnectionManager();
 
     bool EstablishConnection(std::string_view host, int port, std::string_view key, std::string_view shortcut = "");
+    // Validates and stores the parameters like EstablishConnection, then
+    // stays hibernating until Wake.
+    bool PrepareConnection(std::string_view host, int port, std::string_view key, std::string_view shortcut = "");
+    // Connects on the reconnect thread without blocking the caller, or skips
+    // the remaining retry delay if a reconnect is already pending.
+    void Wake(bool announce = true);
+    // Closes the connection but keeps the parameters and the TLS session, so
+    // the next Wake can resume it.
+    void Hibernate();
+    bool IsHibernating() const { return m_hibernating; }
     bool Reconnect();
     void Disconnect();
+    void HandleIncomingMessage(std::string_view message);
+    // Joins the string items of a speak sequence with single spaces. The
+    // view stays valid until the next call on the same thread.
+    static std::string_view JoinSpeechSequence(const json& sequence);
+    void OnConnectionLost();
+    void RequestShutdown();
+    // Tears the managers down in parallel. Returns false if some were still
+    // closing when the deadline passed; those are left to finish detached.
+    static bool ShutdownAll(std::vector<std::unique_ptr<ConnectionManager>> managers,
+                            std::chrono::milliseconds deadline);
     void SetDisconnectCallback(std::function<void()> callback);
     void SetReconnectCallback(std::function<void()> callback) { m_reconnectCallback = callback; }
     std::shared_ptr<NetworkClient> GetClient() { return m_client; }
@@ -59,9 +90,17 @@ public:
     void SetMuteOnLocalControl(bool enabled) { m_muteOnLocalControl = enabled; }
     void SetForwardAudioEnabled(bool enabled) { m_forwardAudio = enabled; }
     void SetProfileIndex(int index) { m_profileIndex = index; }
+    void SetEarlyDataEnabled(bool enabled);
     void ApplyProfileConfig(const ProfileConfig& p) {
         SetSpeechEnabled(p.speech);
         SetMuteOnLocalControl(p.muteOnLocalControl);
         SetForwardAudioEnabled(p.forwardAudio);
+        ApplySendQueueLimits(p);
+        ApplyConnectTimeouts(p);
+        SetEarlyDataEnabled(p.earlyData);
+        ApplyOnDemand(p);
     }
+    void ApplySendQueueLimits(const ProfileConfig& p);
+    void ApplyConnectTimeouts(const ProfileConfig& p);
+    void ApplyOnDemand(const ProfileConfig& p);
 };
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include "DnsCache.h"
+#include "Debug.h"
+#include <thread>
+
+std::mutex DnsCache::s_mutex;
+std::unordered_map<std::string, DnsCache::Entry> DnsCache::s_entries;
+DnsCacheStats DnsCache::s_stats;
+
+namespace {
+    std::string CacheKey(const std::string& host, int port) {
+        return host + ":" + std::to_string(port);
+    }
+}
+
+ConnectStatus DnsCache::Resolve(const std::string& host, int port, Clock::time_point deadline,
+                                const std::function<bool()>& keepWaiting,
+                                std::vector<ResolvedAddress>& out) {
+    auto key = CacheKey(host, port);
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        auto it = s_entries.find(key);
+        if (it != s_entries.end()) {
+            auto age = Clock::now() - it->second.resolvedAt;
+            if (age > std::chrono::milliseconds(Config::DNS_CACHE_MAX_STALE_MS)) {
+                s_entries.erase(it);
+            } else {
+                out = it->second.addresses;
+                if (!it->second.stale && age <= std::chrono::milliseconds(Config::DNS_CACHE_TTL_MS)) {
+                    s_stats.hits++;
+                    return ConnectStatus::Ok;
+                }
+                it->second.stale = true;
+                s_stats.staleHits++;
+                bool refresh = !it->second.refreshing;
+                it->second.refreshing = true;
+                if (refresh) StartRefresh(key, host, port);
+                return ConnectStatus::Ok;
+            }
+        }
+        s_stats.misses++;
+    }
+
+    ConnectStatus status = TcpConnector::Resolve(host, port, deadline, keepWaiting, out);
+    if (status == ConnectStatus::Ok) {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        auto& entry = s_entries[key];
+        entry.addresses = out;
+        entry.resolvedAt = Clock::now();
+        entry.stale = false;
+    }
+    return status;
+}
+
+// Called with s_mutex held. The lookup runs on its own thread; on failure
+// the stale addresses are kept and the next Resolve tries again.
+void DnsCache::StartRefresh(const std::string& key, const std::string& host, int port) {
+    s_stats.refreshes++;
+    std::thread([key, host, port]() {
+        std::vector<ResolvedAddress> addresses;
+        auto deadline = Clock::now() + std::chrono::milliseconds(Config::DNS_TIMEOUT_MS);
+        ConnectStatus status = TcpConnector::Resolve(host, port, deadline, nullptr, addresses);
+
+        std::lock_guard<std::mutex> lock(s_mutex);
+        auto it = s_entries.find(key);
+        if (it == s_entries.end()) return;
+        it->second.refreshing = false;
+        if (status != ConnectStatus::Ok) {
+            s_stats.refreshFailures++;
+            DEBUG_WARN_F("NETWORK", "Background DNS refresh for {} {}", host, DescribeConnectStatus(status));
+            return;
+        }
+        it->second.addresses = std::move(addresses);
+        it->second.resolvedAt = Clock::now();
+        it->second.stale = false;
+        DEBUG_VERBOSE_F("NETWORK", "DNS cache refreshed {}", key);
+    }).detach();
+}
+
+void DnsCache::Refresh(const std::string& host, int port) {
+    auto key = CacheKey(host, port);
+    std::lock_guard<std::mutex> lock(s_mutex);
+    auto it = s_entries.find(key);
+    if (it == s_entries.end()) return;
+    it->second.stale = true;
+    if (it->second.refreshing) return;
+    it->second.refreshing = true;
+    StartRefresh(key, host, port);
+}
+
+void DnsCache::Clear() {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_entries.clear();
+    s_stats = {};
+}
+
+DnsCacheStats DnsCache::GetStats() {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    DnsCacheStats stats = s_stats;
+    stats.entries = s_entries.size();
+    uint64_t lookups = stats.hits + stats.staleHits + stats.misses;
+    if (lookups > 0) {
+        stats.hitRate = static_cast<double>(stats.hits + stats.staleHits) / static_cast<double>(lookups);
+    }
+    return stats;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "TcpConnector.h"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct DnsCacheStats {
+    size_t entries = 0;
+    uint64_t hits = 0;
+    uint64_t staleHits = 0;
+    uint64_t misses = 0;
+    uint64_t refreshes = 0;
+    uint64_t refreshFailures = 0;
+    double hitRate = 0.0;
+};
+
+// Resolved addresses shared by every connection in the process, keyed by
+// host and port. getaddrinfo does not report record TTLs, so entries stay
+// fresh for DNS_CACHE_TTL_MS. After that they are still served, for up to
+// DNS_CACHE_MAX_STALE_MS, while a background lookup replaces them, so a
+// reconnect only waits on DNS the first time a host is seen.
+class DnsCache {
+private:
+    using Clock = TcpConnector::Clock;
+
+    struct Entry {
+        std::vector<ResolvedAddress> addresses;
+        Clock::time_point resolvedAt;
+        bool stale = false;
+        bool refreshing = false;
+    };
+
+    static std::mutex s_mutex;
+    static std::unordered_map<std::string, Entry> s_entries;
+    static DnsCacheStats s_stats;
+
+    static void StartRefresh(const std::string& key, const std::string& host, int port);
+
+public:
+    static ConnectStatus Resolve(const std::string& host, int port, Clock::time_point deadline,
+                                 const std::function<bool()>& keepWaiting,
+                                 std::vector<ResolvedAddress>& out);
+    // Marks the entry stale and looks the host up again in the background,
+    // e.g. after none of its addresses accepted a connection.
+    static void Refresh(const std::string& host, int port);
+    static void Clear();
+    static DnsCacheStats GetStats();
+};
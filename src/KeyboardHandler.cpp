@@ -12,44 +12,45 @@ void KeyboardHandler::SetReconnectCallback(std::function<void()> callback) {
 }
 
 bool KeyboardHandler::HandleShortcut(uint32_t vkCode) {
-    if (KeyboardState::CheckForwardKeysShortcut(vkCode)) {
+    ShortcutBinding binding = KeyboardState::LookupShortcut(vkCode);
+    if (binding.action == ShortcutAction::None) return false;
+
+    if (binding.action == ShortcutAction::ForwardKeys) {
         KeyboardState::ResetModifiers();
         AppState::ToggleForwarding();
         return true;
     }
 
-    if (AppState::IsSendingKeys()) return false;
-
-    if (KeyboardState::CheckExitShortcut(vkCode)) {
-        KeyboardState::ResetModifiers();
-        OnExit();
-        return true;
-    }
-    if (KeyboardState::CheckReinstallHookShortcut(vkCode)) {
-        KeyboardState::ResetModifiers();
-        OnReinstallHook();
-        return true;
-    }
-    if (KeyboardState::CheckClipboardShortcut(vkCode)) {
-        KeyboardState::ResetModifiers();
-        OnClipboardShortcut();
-        return true;
-    }
-    if (KeyboardState::CheckReconnectShortcut(vkCode)) {
-        KeyboardState::ResetModifiers();
-        if (m_reconnectCallback) m_reconnectCallback();
-        return true;
-    }
-    if (KeyboardState::CheckCycleShortcut(vkCode)) {
+    if (binding.action == ShortcutAction::Broadcast) {
         KeyboardState::ResetModifiers();
-        AppState::CycleProfile();
+        AppState::ToggleBroadcast();
         return true;
     }
-    int profileIndex = KeyboardState::CheckToggleShortcut(vkCode);
-    if (profileIndex >= 0) {
-        KeyboardState::ResetModifiers();
-        AppState::SetActiveProfile(profileIndex);
-        return true;
+
+    if (AppState::IsSendingKeys()) return false;
+
+    KeyboardState::ResetModifiers();
+    switch (binding.action) {
+        case ShortcutAction::Exit:
+            OnExit();
+            break;
+        case ShortcutAction::ReinstallHook:
+            OnReinstallHook();
+            break;
+        case ShortcutAction::Clipboard:
+            OnClipboardShortcut();
+            break;
+        case ShortcutAction::Reconnect:
+            if (m_reconnectCallback) m_reconnectCallback();
+            break;
+        case ShortcutAction::Cycle:
+            AppState::CycleProfile();
+            break;
+        case ShortcutAction::Toggle:
+            AppState::SetActiveProfile(binding.profileIndex);
+            break;
+        default:
+            break;
     }
-    return false;
+    return true;
 }
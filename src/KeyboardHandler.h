@@ -12,7 +12,6 @@ public:
     virtual bool Install() = 0;
     virtual void Uninstall() = 0;
     virtual void RunMessageLoop() = 0;
-    virtual void NotifyConnectionLost() = 0;
 
     virtual void Reinstall();
 
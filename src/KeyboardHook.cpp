@@ -29,8 +29,8 @@ void KeyboardHook::OnClipboardShortcut() {
         Speech::Speak("Clipboard is empty", false);
         return;
     }
-    MessageSender::SendClipboardText(text);
-    Speech::Speak("Clipboard sent", false);
+    auto result = MessageSender::SendClipboardText(text);
+    Speech::Speak(MessageSender::DescribeClipboardResult(result), false);
 }
 
 LRESULT KeyboardHook::ProcessKeyEvent(WPARAM wParam, DWORD vkCode, WORD scanCode, bool isExtended) {
@@ -105,11 +105,6 @@ void KeyboardHook::Reinstall() {
     }
 }
 
-void KeyboardHook::NotifyConnectionLost() {
-    if (g_mainThreadId != 0)
-        PostThreadMessage(g_mainThreadId, WM_CONNECTION_LOST, 0, 0);
-}
-
 void KeyboardHook::RunMessageLoop() {
     MSG msg;
     DEBUG_INFO("HOOK", "Starting message loop");
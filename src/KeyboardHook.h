@@ -12,7 +12,6 @@ public:
     void Uninstall() override;
     void Reinstall() override;
     void RunMessageLoop() override;
-    void NotifyConnectionLost() override;
 
 protected:
     void OnExit() override;
@@ -11,10 +11,7 @@
 #define WIN_KEY_1  VK_LWIN
 #define WIN_KEY_2  VK_RWIN
 
-bool KeyboardState::g_ctrlPressed = false;
-bool KeyboardState::g_winPressed = false;
-bool KeyboardState::g_altPressed = false;
-bool KeyboardState::g_shiftPressed = false;
+std::atomic<uint8_t> KeyboardState::g_modifierMask{0};
 
 std::vector<ShortcutConfig> KeyboardState::g_shortcuts;
 ShortcutConfig KeyboardState::g_cycleShortcut;
@@ -23,6 +20,9 @@ ShortcutConfig KeyboardState::g_reinstallHookShortcut;
 ShortcutConfig KeyboardState::g_reconnectShortcut;
 ShortcutConfig KeyboardState::g_clipboardShortcut;
 ShortcutConfig KeyboardState::g_forwardKeysShortcut;
+ShortcutConfig KeyboardState::g_broadcastShortcut;
+RcuSnapshot<KeyboardState::DispatchTable> KeyboardState::g_dispatchTable;
+std::mutex KeyboardState::g_pressedKeysMutex;
 std::vector<PressedKey> KeyboardState::g_pressedKeyDetails;
 
 bool KeyboardState::IsControlKey(NativeKeyType vkCode) {
@@ -41,18 +41,54 @@ bool KeyboardState::IsShiftKey(NativeKeyType vkCode) {
     return vkCode == VK_SHIFT || vkCode == VK_LSHIFT || vkCode == VK_RSHIFT;
 }
 
+static uint8_t ModifierBitFor(NativeKeyType vkCode) {
+    if (KeyboardState::IsControlKey(vkCode)) return ModifierBits::CTRL;
+    if (KeyboardState::IsWinKey(vkCode))     return ModifierBits::WIN;
+    if (KeyboardState::IsAltKey(vkCode))     return ModifierBits::ALT;
+    if (KeyboardState::IsShiftKey(vkCode))   return ModifierBits::SHIFT;
+    return 0;
+}
+
 void KeyboardState::UpdateModifierState(NativeKeyType vkCode, bool isPressed) {
-    if (IsControlKey(vkCode)) g_ctrlPressed = isPressed;
-    if (IsWinKey(vkCode)) g_winPressed = isPressed;
-    if (IsAltKey(vkCode)) g_altPressed = isPressed;
-    if (IsShiftKey(vkCode)) g_shiftPressed = isPressed;
+    uint8_t bit = ModifierBitFor(vkCode);
+    if (bit == 0) return;
+    if (isPressed) g_modifierMask.fetch_or(bit, std::memory_order_relaxed);
+    else           g_modifierMask.fetch_and(static_cast<uint8_t>(~bit), std::memory_order_relaxed);
+}
+
+ShortcutBinding KeyboardState::LookupShortcut(NativeKeyType vkCode) {
+    if (vkCode == 0 || vkCode >= VK_TABLE_SIZE) return {};
+    auto table = g_dispatchTable.Read();
+    return (*table)[(static_cast<size_t>(vkCode) << ModifierBits::COUNT) | GetModifierMask()];
+}
+
+void KeyboardState::BindShortcut(DispatchTable& table, const ShortcutConfig& sc,
+                                 ShortcutAction action, int profileIndex) {
+    if (sc.key == 0 || sc.key >= VK_TABLE_SIZE) return;
+    auto& slot = table[(static_cast<size_t>(sc.key) << ModifierBits::COUNT) | sc.ModifierMask()];
+    if (slot.action != ShortcutAction::None) {
+        DEBUG_VERBOSE_F("KEYS", "Shortcut collision on VK {}, keeping earlier binding", sc.key);
+        return;
+    }
+    slot.action = action;
+    slot.profileIndex = static_cast<int16_t>(profileIndex);
 }
 
-static bool MatchesShortcut(const ShortcutConfig& sc, NativeKeyType vkCode,
-                            bool ctrl, bool win, bool alt, bool shift) {
-    if (sc.key == 0) return false;
-    if (vkCode != sc.key) return false;
-    return (ctrl == sc.ctrl) && (win == sc.win) && (alt == sc.alt) && (shift == sc.shift);
+void KeyboardState::RebuildDispatchTable() {
+    DispatchTable table{};
+
+    BindShortcut(table, g_forwardKeysShortcut,   ShortcutAction::ForwardKeys);
+    BindShortcut(table, g_broadcastShortcut,     ShortcutAction::Broadcast);
+    BindShortcut(table, g_exitShortcut,          ShortcutAction::Exit);
+    BindShortcut(table, g_reinstallHookShortcut, ShortcutAction::ReinstallHook);
+    BindShortcut(table, g_clipboardShortcut,     ShortcutAction::Clipboard);
+    BindShortcut(table, g_reconnectShortcut,     ShortcutAction::Reconnect);
+    BindShortcut(table, g_cycleShortcut,         ShortcutAction::Cycle);
+    for (int i = 0; i < static_cast<int>(g_shortcuts.size()); i++) {
+        BindShortcut(table, g_shortcuts[i], ShortcutAction::Toggle, i);
+    }
+
+    g_dispatchTable.Publish(table);
 }
 
 static std::string ShortcutToString(const ShortcutConfig& sc) {
@@ -93,24 +129,17 @@ void KeyboardState::ApplyGlobalShortcut(ShortcutConfig& sc, const std::string& s
     if (sc.key != 0) {
         DEBUG_INFO_F("KEYS", "{} shortcut set to: {}", name, ShortcutToString(sc));
     }
-}
-
-bool KeyboardState::CheckGlobalShortcut(const ShortcutConfig& sc, NativeKeyType vkCode) {
-    return MatchesShortcut(sc, vkCode, g_ctrlPressed, g_winPressed, g_altPressed, g_shiftPressed);
+    RebuildDispatchTable();
 }
 
 int KeyboardState::CheckToggleShortcut(NativeKeyType vkCode) {
-    for (int i = 0; i < static_cast<int>(g_shortcuts.size()); i++) {
-        if (MatchesShortcut(g_shortcuts[i], vkCode,
-                            g_ctrlPressed, g_winPressed, g_altPressed, g_shiftPressed)) {
-            return i;
-        }
-    }
-    return -1;
+    auto binding = LookupShortcut(vkCode);
+    return binding.action == ShortcutAction::Toggle ? binding.profileIndex : -1;
 }
 
 void KeyboardState::ClearShortcuts() {
     g_shortcuts.clear();
+    RebuildDispatchTable();
     DEBUG_VERBOSE("KEYS", "All shortcuts cleared");
 }
 
@@ -126,6 +155,7 @@ void KeyboardState::SetToggleShortcutAt(int index, const std::string& shortcut)
         g_shortcuts.push_back({});
     }
     g_shortcuts[index] = sc;
+    RebuildDispatchTable();
     DEBUG_INFO_F("KEYS", "Shortcut[{}] set to: {}", index, ShortcutToString(sc));
 }
 
@@ -134,7 +164,7 @@ void KeyboardState::SetCycleShortcut(const std::string& shortcut) {
 }
 
 bool KeyboardState::CheckCycleShortcut(NativeKeyType vkCode) {
-    return CheckGlobalShortcut(g_cycleShortcut, vkCode);
+    return LookupShortcut(vkCode).action == ShortcutAction::Cycle;
 }
 
 void KeyboardState::SetExitShortcut(const std::string& shortcut) {
@@ -142,7 +172,7 @@ void KeyboardState::SetExitShortcut(const std::string& shortcut) {
 }
 
 bool KeyboardState::CheckExitShortcut(NativeKeyType vkCode) {
-    return CheckGlobalShortcut(g_exitShortcut, vkCode);
+    return LookupShortcut(vkCode).action == ShortcutAction::Exit;
 }
 
 void KeyboardState::SetReinstallHookShortcut(const std::string& shortcut) {
@@ -150,7 +180,7 @@ void KeyboardState::SetReinstallHookShortcut(const std::string& shortcut) {
 }
 
 bool KeyboardState::CheckReinstallHookShortcut(NativeKeyType vkCode) {
-    return CheckGlobalShortcut(g_reinstallHookShortcut, vkCode);
+    return LookupShortcut(vkCode).action == ShortcutAction::ReinstallHook;
 }
 
 void KeyboardState::SetReconnectShortcut(const std::string& shortcut) {
@@ -158,7 +188,7 @@ void KeyboardState::SetReconnectShortcut(const std::string& shortcut) {
 }
 
 bool KeyboardState::CheckReconnectShortcut(NativeKeyType vkCode) {
-    return CheckGlobalShortcut(g_reconnectShortcut, vkCode);
+    return LookupShortcut(vkCode).action == ShortcutAction::Reconnect;
 }
 
 void KeyboardState::SetClipboardShortcut(const std::string& shortcut) {
@@ -166,7 +196,7 @@ void KeyboardState::SetClipboardShortcut(const std::string& shortcut) {
 }
 
 bool KeyboardState::CheckClipboardShortcut(NativeKeyType vkCode) {
-    return CheckGlobalShortcut(g_clipboardShortcut, vkCode);
+    return LookupShortcut(vkCode).action == ShortcutAction::Clipboard;
 }
 
 void KeyboardState::SetForwardKeysShortcut(const std::string& shortcut) {
@@ -174,7 +204,15 @@ void KeyboardState::SetForwardKeysShortcut(const std::string& shortcut) {
 }
 
 bool KeyboardState::CheckForwardKeysShortcut(NativeKeyType vkCode) {
-    return CheckGlobalShortcut(g_forwardKeysShortcut, vkCode);
+    return LookupShortcut(vkCode).action == ShortcutAction::ForwardKeys;
+}
+
+void KeyboardState::SetBroadcastShortcut(const std::string& shortcut) {
+    ApplyGlobalShortcut(g_broadcastShortcut, shortcut, "Broadcast");
+}
+
+bool KeyboardState::CheckBroadcastShortcut(NativeKeyType vkCode) {
+    return LookupShortcut(vkCode).action == ShortcutAction::Broadcast;
 }
 
 static NativeKeyType ParseKey(const std::string& keyName) {
@@ -238,13 +276,11 @@ ShortcutConfig KeyboardState::ParseShortcutString(const std::string& shortcut) {
 }
 
 void KeyboardState::ResetModifiers() {
-    g_ctrlPressed = false;
-    g_winPressed = false;
-    g_altPressed = false;
-    g_shiftPressed = false;
+    g_modifierMask.store(0, std::memory_order_relaxed);
 }
 
 void KeyboardState::TrackKeyPress(NativeKeyType vkCode, NativeScanType scanCode, bool extended) {
+    std::lock_guard<std::mutex> lock(g_pressedKeysMutex);
     for (const auto& pk : g_pressedKeyDetails) {
         if (pk.vkCode == vkCode) return;
     }
@@ -252,6 +288,7 @@ void KeyboardState::TrackKeyPress(NativeKeyType vkCode, NativeScanType scanCode,
 }
 
 bool KeyboardState::TrackKeyRelease(NativeKeyType vkCode) {
+    std::lock_guard<std::mutex> lock(g_pressedKeysMutex);
     auto it = std::remove_if(g_pressedKeyDetails.begin(), g_pressedKeyDetails.end(),
                              [vkCode](const PressedKey& key) { return key.vkCode == vkCode; });
     if (it == g_pressedKeyDetails.end()) return false;
@@ -259,11 +296,20 @@ bool KeyboardState::TrackKeyRelease(NativeKeyType vkCode) {
     return true;
 }
 
-const std::vector<PressedKey>& KeyboardState::GetAllPressedKeys() {
+std::vector<PressedKey> KeyboardState::GetAllPressedKeys() {
+    std::lock_guard<std::mutex> lock(g_pressedKeysMutex);
     return g_pressedKeyDetails;
 }
 
+std::vector<PressedKey> KeyboardState::TakeAllPressedKeys() {
+    std::vector<PressedKey> keys;
+    std::lock_guard<std::mutex> lock(g_pressedKeysMutex);
+    keys.swap(g_pressedKeyDetails);
+    return keys;
+}
+
 void KeyboardState::ClearPressedKeys() {
+    std::lock_guard<std::mutex> lock(g_pressedKeysMutex);
     g_pressedKeyDetails.clear();
 }
 
@@ -278,4 +324,7 @@ void KeyboardState::ApplyGlobalShortcuts(const ConfigFileData& cfg) {
 
     std::string fwSc = cfg.forwardKeysShortcut.value_or(Config::DEFAULT_FORWARD_KEYS_SHORTCUT);
     if (!fwSc.empty()) SetForwardKeysShortcut(fwSc);
+
+    if (cfg.broadcastShortcut && !cfg.broadcastShortcut->empty())
+        SetBroadcastShortcut(*cfg.broadcastShortcut);
 }
@@ -1,8 +1,12 @@
 #pragma once
+#include <array>
+#include <atomic>
 #include <cstdint>
+#include <mutex>
 #include <vector>
 #include <string>
 #include "ConfigFile.h"
+#include "RcuSnapshot.h"
 
 #ifdef _WIN32
     #include <windows.h>
@@ -104,20 +108,56 @@ struct PressedKey {
         : vkCode(static_cast<uint32_t>(vk)), scanCode(static_cast<uint16_t>(scan)), extended(ext) {}
 };
 
+namespace ModifierBits {
+    constexpr uint8_t CTRL  = 1 << 0;
+    constexpr uint8_t WIN   = 1 << 1;
+    constexpr uint8_t ALT   = 1 << 2;
+    constexpr uint8_t SHIFT = 1 << 3;
+    constexpr int COUNT = 4;
+}
+
 struct ShortcutConfig {
     bool ctrl = false;
     bool win = false;
     bool alt = false;
     bool shift = false;
     NativeKeyType key = 0;
+
+    uint8_t ModifierMask() const {
+        return (ctrl  ? ModifierBits::CTRL  : 0) |
+               (win   ? ModifierBits::WIN   : 0) |
+               (alt   ? ModifierBits::ALT   : 0) |
+               (shift ? ModifierBits::SHIFT : 0);
+    }
+};
+
+enum class ShortcutAction : uint8_t {
+    None,
+    ForwardKeys,
+    Broadcast,
+    Exit,
+    ReinstallHook,
+    Clipboard,
+    Reconnect,
+    Cycle,
+    Toggle
+};
+
+struct ShortcutBinding {
+    ShortcutAction action = ShortcutAction::None;
+    int16_t profileIndex = -1;
 };
 
 class KeyboardState {
 private:
-    static bool g_ctrlPressed;
-    static bool g_winPressed;
-    static bool g_altPressed;
-    static bool g_shiftPressed;
+    static constexpr size_t VK_TABLE_SIZE = 256;
+    static constexpr size_t DISPATCH_TABLE_SIZE = VK_TABLE_SIZE << ModifierBits::COUNT;
+    using DispatchTable = std::array<ShortcutBinding, DISPATCH_TABLE_SIZE>;
+
+    // Written by the keyboard thread; read and cleared from whichever thread
+    // changes routing, so both are synchronized.
+    static std::atomic<uint8_t> g_modifierMask;
+    static std::mutex g_pressedKeysMutex;
     static std::vector<PressedKey> g_pressedKeyDetails;
 
     static std::vector<ShortcutConfig> g_shortcuts;
@@ -127,9 +167,13 @@ private:
     static ShortcutConfig g_reconnectShortcut;
     static ShortcutConfig g_clipboardShortcut;
     static ShortcutConfig g_forwardKeysShortcut;
+    static ShortcutConfig g_broadcastShortcut;
+    static RcuSnapshot<DispatchTable> g_dispatchTable;
 
     static void ApplyGlobalShortcut(ShortcutConfig& sc, const std::string& shortcut, const char* name);
-    static bool CheckGlobalShortcut(const ShortcutConfig& sc, NativeKeyType vkCode);
+    static void RebuildDispatchTable();
+    static void BindShortcut(DispatchTable& table, const ShortcutConfig& sc,
+                             ShortcutAction action, int profileIndex = -1);
 
 public:
     static bool IsControlKey(NativeKeyType vkCode);
@@ -138,7 +182,9 @@ public:
     static bool IsShiftKey(NativeKeyType vkCode);
 
     static void UpdateModifierState(NativeKeyType vkCode, bool isPressed);
+    static uint8_t GetModifierMask() { return g_modifierMask.load(std::memory_order_relaxed); }
 
+    static ShortcutBinding LookupShortcut(NativeKeyType vkCode);
     static int CheckToggleShortcut(NativeKeyType vkCode);
     static bool CheckCycleShortcut(NativeKeyType vkCode);
     static void SetCycleShortcut(const std::string& shortcut);
@@ -152,6 +198,8 @@ public:
     static bool CheckClipboardShortcut(NativeKeyType vkCode);
     static void SetForwardKeysShortcut(const std::string& shortcut);
     static bool CheckForwardKeysShortcut(NativeKeyType vkCode);
+    static void SetBroadcastShortcut(const std::string& shortcut);
+    static bool CheckBroadcastShortcut(NativeKeyType vkCode);
 
 
     static void SetToggleShortcut(const std::string& shortcut);
@@ -162,7 +210,10 @@ public:
 
     static void TrackKeyPress(NativeKeyType vkCode, NativeScanType scanCode, bool extended);
     static bool TrackKeyRelease(NativeKeyType vkCode);
-    static const std::vector<PressedKey>& GetAllPressedKeys();
+    static std::vector<PressedKey> GetAllPressedKeys();
+    // Empties the pressed-key list and returns what it held, in one step, so
+    // a key pressed meanwhile is either returned or still tracked.
+    static std::vector<PressedKey> TakeAllPressedKeys();
     static void ClearPressedKeys();
 
     static void ClearShortcuts();
@@ -400,8 +400,8 @@ void LinuxKeyboardGrab::OnClipboardShortcut() {
         Speech::Speak("Clipboard is empty", false);
         return;
     }
-    MessageSender::SendClipboardText(text);
-    Speech::Speak("Clipboard sent", false);
+    auto result = MessageSender::SendClipboardText(text);
+    Speech::Speak(MessageSender::DescribeClipboardResult(result), false);
 }
 
 bool LinuxKeyboardGrab::Install() {
@@ -456,13 +456,6 @@ void LinuxKeyboardGrab::Reinstall() {
     DEBUG_INFO("LKG", "Linux keyboard grab reinstalled");
 }
 
-void LinuxKeyboardGrab::NotifyConnectionLost() {
-    if (g_wakeupPipe[1] >= 0) {
-        char b = 'c';
-        write(g_wakeupPipe[1], &b, 1);
-    }
-}
-
 void LinuxKeyboardGrab::RunMessageLoop() {
     DEBUG_INFO("LKG", "Starting Linux keyboard grab message loop");
 
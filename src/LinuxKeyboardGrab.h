@@ -9,7 +9,6 @@ public:
     void Uninstall() override;
     void Reinstall() override;
     void RunMessageLoop() override;
-    void NotifyConnectionLost() override;
 
 protected:
     void OnExit() override;
@@ -1,41 +1,103 @@
 #include "MessageSender.h"
 #include "NetworkClient.h"
+#include "RoutingState.h"
 #include "Config.h"
+#include "SpeechQueue.h"
 #include "Debug.h"
 #include <nlohmann/json.hpp>
 
-std::vector<std::weak_ptr<NetworkClient>> MessageSender::s_clients;
-int MessageSender::s_activeProfile = -1;
-
 void MessageSender::SetNetworkClient(int index, std::shared_ptr<NetworkClient> client) {
-    while (static_cast<int>(s_clients.size()) <= index) {
-        s_clients.push_back({});
-    }
-    s_clients[index] = client;
+    if (index < 0) return;
+    RoutingState::Update([&](RoutingSnapshot& s) {
+        if (static_cast<int>(s.clients.size()) <= index) {
+            s.clients.resize(index + 1);
+        }
+        s.clients[index] = client;
+    });
 }
 
-void MessageSender::SetActiveProfile(int index) {
-    s_activeProfile = index;
+std::shared_ptr<NetworkClient> MessageSender::ActiveClient(int* profileIndex) {
+    auto routing = RoutingState::Read();
+    int active = routing->activeProfile;
+    if (profileIndex) *profileIndex = active;
+    if (active < 0 || active >= static_cast<int>(routing->clients.size())) return nullptr;
+    return routing->clients[active].lock();
 }
 
-void MessageSender::SendClipboardText(const std::string& text) {
-    if (s_activeProfile < 0 || s_activeProfile >= static_cast<int>(s_clients.size())) return;
-    if (auto client = s_clients[s_activeProfile].lock()) {
-        nlohmann::ordered_json msg;
-        msg["type"] = Config::MSG_TYPE_SET_CLIPBOARD_TEXT;
-        msg["text"] = text;
-        client->SendJsonMessage(msg);
-        DEBUG_INFO("CLIP", "Clipboard text sent to remote");
+ClipboardSendResult MessageSender::SendClipboardText(const std::string& text) {
+    if (text.size() > Config::MAX_CLIPBOARD_BYTES) {
+        DEBUG_WARN_F("CLIP", "Clipboard text too large ({} bytes, limit {})", text.size(), Config::MAX_CLIPBOARD_BYTES);
+        return ClipboardSendResult::TooLarge;
     }
+
+    auto client = ActiveClient();
+    if (!client) return ClipboardSendResult::NotSent;
+
+    nlohmann::ordered_json msg;
+    msg["type"] = Config::MSG_TYPE_SET_CLIPBOARD_TEXT;
+    msg["text"] = text;
+
+    SendProgress progress;
+    if (text.size() >= Config::CLIPBOARD_PROGRESS_BYTES) {
+        progress = [lastQuarter = 0](size_t sent, size_t total) mutable {
+            int quarter = static_cast<int>(sent * 4 / total);
+            if (quarter == lastQuarter) return;
+            lastQuarter = quarter;
+            if (quarter < 4) {
+                SpeechQueue::Enqueue("Clipboard " + std::to_string(quarter * 25) + " percent", false);
+            } else {
+                DEBUG_INFO("CLIP", "Clipboard text sent to remote");
+                SpeechQueue::Enqueue("Clipboard sent", false);
+            }
+        };
+    }
+
+    const bool streaming = static_cast<bool>(progress);
+    if (!client->SendJsonMessage(msg, SendKind::Clipboard, std::move(progress))) {
+        DEBUG_WARN("CLIP", "Clipboard text not sent, send queue full");
+        return ClipboardSendResult::NotSent;
+    }
+    if (streaming) {
+        DEBUG_INFO_F("CLIP", "Streaming {} bytes of clipboard text to remote", text.size());
+        return ClipboardSendResult::Streaming;
+    }
+    DEBUG_INFO("CLIP", "Clipboard text sent to remote");
+    return ClipboardSendResult::Sent;
+}
+
+const char* MessageSender::DescribeClipboardResult(ClipboardSendResult result) {
+    switch (result) {
+        case ClipboardSendResult::Sent: return "Clipboard sent";
+        case ClipboardSendResult::Streaming: return "Sending clipboard";
+        case ClipboardSendResult::TooLarge: return "Clipboard too large";
+        case ClipboardSendResult::NotSent: break;
+    }
+    return "Clipboard not sent";
 }
 
 void MessageSender::SendKeyEvent(const KeyEvent& keyEvent) {
-    if (s_activeProfile < 0 || s_activeProfile >= static_cast<int>(s_clients.size())) {
-        return;
+    {
+        auto routing = RoutingState::Read();
+        if (routing->broadcasting) {
+            auto framed = NetworkClient::FrameMessage(keyEvent.ToJson().dump());
+            SendKind kind = keyEvent.pressed ? SendKind::KeyPress : SendKind::KeyRelease;
+            int targets = 0;
+            for (int index : routing->broadcastProfiles) {
+                if (index < 0 || index >= static_cast<int>(routing->clients.size())) continue;
+                if (auto client = routing->clients[index].lock()) {
+                    if (client->SendFramedMessage(framed, kind, keyEvent.vk_code)) targets++;
+                }
+            }
+            DEBUG_VERBOSE_F("KEYS", "Broadcast key to {} profiles: VK={}, pressed={}",
+                           targets, keyEvent.vk_code, keyEvent.pressed);
+            return;
+        }
     }
-    if (auto client = s_clients[s_activeProfile].lock()) {
+
+    int activeProfile = -1;
+    if (auto client = ActiveClient(&activeProfile)) {
         DEBUG_VERBOSE_F("KEYS", "Sending key to profile {}: VK={}, pressed={}, scan={}, extended={}",
-                       s_activeProfile, keyEvent.vk_code, keyEvent.pressed, keyEvent.scan_code, keyEvent.extended);
+                       activeProfile, keyEvent.vk_code, keyEvent.pressed, keyEvent.scan_code, keyEvent.extended);
         client->SendKeyEvent(keyEvent.ToJson());
     }
 }
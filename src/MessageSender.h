@@ -2,18 +2,25 @@
 #include "KeyEvent.h"
 #include <string>
 #include <memory>
-#include <vector>
 
 class NetworkClient;
 
+enum class ClipboardSendResult {
+    Sent,
+    Streaming,
+    TooLarge,
+    NotSent
+};
+
 class MessageSender {
 private:
-    static std::vector<std::weak_ptr<NetworkClient>> s_clients;
-    static int s_activeProfile;
+    static std::shared_ptr<NetworkClient> ActiveClient(int* profileIndex = nullptr);
 
 public:
     static void SetNetworkClient(int index, std::shared_ptr<NetworkClient> client);
-    static void SetActiveProfile(int index);
     static void SendKeyEvent(const KeyEvent& keyEvent);
-    static void SendClipboardText(const std::string& text);
+    // Text above Config::MAX_CLIPBOARD_BYTES is refused. Large transfers are
+    // queued behind any pending keys and announce their progress as they go.
+    static ClipboardSendResult SendClipboardText(const std::string& text);
+    static const char* DescribeClipboardResult(ClipboardSendResult result);
 };
@@ -1,9 +1,11 @@
 #include "NetworkClient.h"
 #include "Debug.h"
 #include "Config.h"
+#include "ReceiveFramer.h"
 #include <iostream>
 #include <thread>
 #include <chrono>
+#include <algorithm>
 
 template<typename F>
 class ScopeGuard {
@@ -33,12 +35,15 @@ NetworkClient::~NetworkClient() {
     Disconnect();
 }
 
-bool NetworkClient::Connect(const std::string& host, int port) {
+bool NetworkClient::Connect(const std::string& host, int port, const ConnectTimeouts& timeouts,
+                            const std::function<bool()>& keepWaiting, std::string_view opening) {
     if (m_connectionState.IsConnected()) {
         return true;
     }
 
-    if (m_sslClient.Connect(host, port)) {
+    if (m_sslClient.Connect(host, port, timeouts, keepWaiting, opening)) {
+        m_sendQueue.Open();
+        m_lastSend = std::chrono::steady_clock::now();
         m_connectionState.TransitionTo(ConnectionState::Status::Connected);
         return true;
     }
@@ -48,44 +53,33 @@ bool NetworkClient::Connect(const std::string& host, int port) {
 
 void NetworkClient::Disconnect() {
     bool expected = false;
-    static std::atomic<bool> disconnectInProgress(false);
-    if (!disconnectInProgress.compare_exchange_strong(expected, true)) {
+    if (!m_disconnecting.compare_exchange_strong(expected, true)) {
         DEBUG_VERBOSE("NETWORK", "Disconnect already in progress, skipping");
         return;
     }
     
     auto disconnectGuard = make_scope_guard([&] {
-        disconnectInProgress.store(false);
+        m_disconnecting.store(false);
     });
     
     DEBUG_INFO("NETWORK", "Starting disconnect sequence");
     
     try {
+        bool wasConnected = m_connectionState.AttemptTransition(ConnectionState::Status::Connected,
+                                                                ConnectionState::Status::Disconnected);
         m_connectionState.TransitionTo(ConnectionState::Status::Disconnected);
-        DEBUG_VERBOSE("NETWORK", "Notifying sender thread");
-        m_sendCondition.notify_all();
-
-        DEBUG_VERBOSE("NETWORK", "Closing SSL connection");
-        m_sslClient.Disconnect();
+        DEBUG_VERBOSE("NETWORK", "Closing send queue");
+        m_sendQueue.Close();
 
         DEBUG_VERBOSE("NETWORK", "Stopping worker threads");
         m_threadPool.StopAll();
 
-        DEBUG_VERBOSE("NETWORK", "Clearing send queue");
-        {
-            std::lock_guard<std::mutex> lock(m_sendMutex);
-            size_t queueSize = m_sendQueue.size();
-            while (!m_sendQueue.empty()) {
-                m_sendQueue.pop();
-            }
-            if (queueSize > 0) {
-                DEBUG_VERBOSE_F("NETWORK", "Cleared {} unsent messages from queue", queueSize);
-            }
-        }
+        DEBUG_VERBOSE("NETWORK", "Closing SSL connection");
+        m_sslClient.Disconnect();
 
         DEBUG_INFO("NETWORK", "Disconnect sequence completed successfully");
 
-        if (m_disconnectCallback) {
+        if (wasConnected && m_disconnectCallback) {
             DEBUG_VERBOSE("NETWORK", "Triggering disconnect callback");
             m_disconnectCallback();
         }
@@ -95,28 +89,36 @@ void NetworkClient::Disconnect() {
     }
 }
 
-bool NetworkClient::SendRawMessage(const std::string& message) {
+std::shared_ptr<const std::string> NetworkClient::FrameMessage(const std::string& message) {
+    auto framed = std::make_shared<std::string>();
+    framed->reserve(message.size() + 1);
+    framed->append(message);
+    *framed += '\n';
+    return framed;
+}
+
+bool NetworkClient::EnqueueFramed(std::shared_ptr<const std::string> framed, SendKind kind, uint32_t vk,
+                                  SendProgress progress) {
     if (!m_connectionState.IsConnected()) {
         DEBUG_ERROR("NETWORK", "Cannot send - not connected");
         return false;
     }
+    m_lastSend = std::chrono::steady_clock::now();
+    return m_sendQueue.Push(std::move(framed), kind, vk, std::move(progress));
+}
 
-    {
-        std::string framed;
-        framed.reserve(message.size() + 1);
-        framed.append(message);
-        framed += '\n';
-        std::lock_guard<std::mutex> lock(m_sendMutex);
-        m_sendQueue.push(std::move(framed));
-    }
-    m_sendCondition.notify_one();
-    
+bool NetworkClient::SendRawMessage(const std::string& message, SendKind kind, SendProgress progress) {
+    if (!EnqueueFramed(FrameMessage(message), kind, 0, std::move(progress))) return false;
     DEBUG_VERBOSE_F("NETWORK", "Queued message for sending: {}", message);
     return true;
 }
 
-bool NetworkClient::SendJsonMessage(const json& message) {
-    return SendRawMessage(message.dump());
+bool NetworkClient::SendFramedMessage(std::shared_ptr<const std::string> framed, SendKind kind, uint32_t vk) {
+    return EnqueueFramed(std::move(framed), kind, vk);
+}
+
+bool NetworkClient::SendJsonMessage(const json& message, SendKind kind, SendProgress progress) {
+    return SendRawMessage(message.dump(), kind, std::move(progress));
 }
 
 void NetworkClient::SetMessageHandler(std::function<void(const std::string&)> handler) {
@@ -127,42 +129,66 @@ void NetworkClient::SetDisconnectCallback(std::function<void()> callback) {
     m_disconnectCallback = callback;
 }
 
+// Called from the sender or receiver thread when the connection fails. Only
+// the first report wins. The threads, socket and TLS state are left for
+// Disconnect, which joins these threads and so cannot run on them.
+void NetworkClient::HandleConnectionLost() {
+    if (!m_connectionState.AttemptTransition(ConnectionState::Status::Connected,
+                                             ConnectionState::Status::Disconnected)) {
+        return;
+    }
+    m_sendQueue.Close();
+    if (m_disconnectCallback) {
+        m_disconnectCallback();
+    }
+}
+
 void NetworkClient::SenderThreadLoop() {
+    m_runningWorkers++;
     DEBUG_INFO("NETWORK", "Sender thread started");
     
-    while (m_connectionState.IsConnected()) {
-        std::unique_lock<std::mutex> lock(m_sendMutex);
-        
-        m_sendCondition.wait(lock, [this] { 
-            return !m_connectionState.IsConnected() || !m_sendQueue.empty(); 
-        });
-        
-        while (!m_sendQueue.empty() && m_connectionState.IsConnected()) {
-            auto message = m_sendQueue.front();
-            m_sendQueue.pop();
-            lock.unlock();
-            
-            auto result = m_sslClient.Send(message.c_str(), static_cast<int>(message.length()));
-            
-            if (result < 0) {
-                DEBUG_ERROR("NETWORK", "SSL send failed");
-                m_connectionState.TransitionTo(ConnectionState::Status::Disconnected);
-                break;
-            }
-            
-            DEBUG_VERBOSE_F("NETWORK", "Actually sent: {} (bytes: {})", 
-                           message.substr(0, message.length()-1), result);
-            
-            lock.lock();
+    std::shared_ptr<const std::string> message;
+    SendProgress progress;
+    while (m_connectionState.IsConnected() && m_sendQueue.WaitPop(message, &progress)) {
+        // Messages with a progress callback are written in bounded slices so
+        // the sender can report how far a large clipboard transfer has got.
+        const size_t total = message->length();
+        size_t sent = 0;
+        int result = 0;
+        while (sent < total) {
+            size_t slice = progress ? std::min(Config::CLIPBOARD_CHUNK_BYTES, total - sent) : total - sent;
+            result = m_sslClient.SendAll(message->data() + sent, static_cast<int>(slice),
+                                         [this] { return m_connectionState.IsConnected(); });
+            if (result < 0) break;
+            sent += static_cast<size_t>(result);
+            if (progress) progress(sent, total);
+        }
+
+        if (result < 0) {
+            DEBUG_ERROR("NETWORK", "SSL send failed");
+            HandleConnectionLost();
+            break;
         }
+
+        DEBUG_VERBOSE_F("NETWORK", "Actually sent: {} (bytes: {})",
+                       message->substr(0, std::min<size_t>(total - 1, 256)), sent);
     }
     
     DEBUG_INFO("NETWORK", "Sender thread terminated");
+    m_runningWorkers--;
 }
 
 void NetworkClient::ReceiverThreadLoop() {
     char buffer[Config::RECEIVER_BUFFER_SIZE];
-    std::string receivedData;
+    ReceiveFramer framer;
+    auto onMessage = [this](std::string_view line) {
+        std::string message(line);
+        DEBUG_VERBOSE_F("NETWORK", "Received message: {}", message);
+        if (m_messageHandler) {
+            m_messageHandler(message);
+        }
+    };
+    m_runningWorkers++;
     DEBUG_INFO("NETWORK", "Receiver thread started");
 
     while (m_connectionState.IsConnected()) {
@@ -170,25 +196,11 @@ void NetworkClient::ReceiverThreadLoop() {
         
         if (bytesReceived > 0) {
             DEBUG_TRACE_F("NETWORK", "Raw SSL received ({} bytes): {}", bytesReceived, std::string(buffer, bytesReceived));
-            receivedData.append(buffer, bytesReceived);
-
-            size_t searchFrom = 0;
-            size_t pos;
-            while ((pos = receivedData.find('\n', searchFrom)) != std::string::npos) {
-                size_t msgLen = pos - searchFrom;
-                if (msgLen > 0 && receivedData[searchFrom + msgLen - 1] == '\r') --msgLen;
-
-                if (msgLen > 0) {
-                    std::string message(receivedData.data() + searchFrom, msgLen);
-                    DEBUG_VERBOSE_F("NETWORK", "Received message: {}", message);
-                    if (m_messageHandler) {
-                        m_messageHandler(message);
-                    }
-                }
-                searchFrom = pos + 1;
-            }
-            if (searchFrom > 0) {
-                receivedData.erase(0, searchFrom);
+            uint64_t discardedBefore = framer.Discarded();
+            framer.Feed(buffer, static_cast<size_t>(bytesReceived), onMessage);
+            if (framer.Discarded() != discardedBefore) {
+                DEBUG_WARN_F("NETWORK", "Dropped message larger than {} bytes ({} so far)",
+                             Config::MAX_MESSAGE_SIZE, framer.Discarded());
             }
         } else if (bytesReceived == -2) {
             std::this_thread::sleep_for(std::chrono::milliseconds(Config::SENDER_SLEEP_MS));
@@ -199,15 +211,13 @@ void NetworkClient::ReceiverThreadLoop() {
             } else {
                  DEBUG_ERROR("NETWORK", "SSL receive failed");
             }
-            m_connectionState.TransitionTo(ConnectionState::Status::Disconnected);
-            if (m_disconnectCallback) {
-                m_disconnectCallback();
-            }
+            HandleConnectionLost();
             break;
         }
     }
     
     DEBUG_INFO("NETWORK", "Receiver thread terminated");
+    m_runningWorkers--;
 }
 
 void NetworkClient::StartReceiving() {
@@ -223,21 +233,27 @@ void NetworkClient::StartReceiving() {
     });
 }
 
-bool NetworkClient::SendProtocolVersion() {
-    json message = {
+json NetworkClient::ProtocolVersionMessage() {
+    return {
         {"version", 2},
         {"type", Config::MSG_TYPE_PROTOCOL_VERSION}
     };
-    return SendJsonMessage(message);
 }
 
-bool NetworkClient::SendJoinChannel(const std::string& channel, const std::string& connectionType) {
-    json message = {
+json NetworkClient::JoinChannelMessage(const std::string& channel, const std::string& connectionType) {
+    return {
         {"channel", channel},
         {"connection_type", connectionType},
         {"type", Config::MSG_TYPE_JOIN}
     };
-    return SendJsonMessage(message);
+}
+
+bool NetworkClient::SendProtocolVersion() {
+    return SendJsonMessage(ProtocolVersionMessage());
+}
+
+bool NetworkClient::SendJoinChannel(const std::string& channel, const std::string& connectionType) {
+    return SendJsonMessage(JoinChannelMessage(channel, connectionType));
 }
 
 bool NetworkClient::SendBrailleInfo() {
@@ -250,5 +266,6 @@ bool NetworkClient::SendBrailleInfo() {
 }
 
 bool NetworkClient::SendKeyEvent(const json& keyEvent) {
-    return SendJsonMessage(keyEvent);
+    SendKind kind = keyEvent.value("pressed", false) ? SendKind::KeyPress : SendKind::KeyRelease;
+    return EnqueueFramed(FrameMessage(keyEvent.dump()), kind, keyEvent.value("vk_code", 0u));
 }
\ No newline at end of file
@@ -2,11 +2,11 @@
 #include <string>
 #include <functional>
 #include <nlohmann/json.hpp>
-#include <queue>
-#include <mutex>
-#include <condition_variable>
+#include <memory>
 #include <atomic>
+#include <chrono>
 #include "SSLClient.h"
+#include "SendQueue.h"
 #include "ThreadManager.h"
 #include "ConnectionState.h"
 
@@ -19,27 +19,50 @@ private:
     std::function<void(const std::string&)> m_messageHandler;
     std::function<void()> m_disconnectCallback;
 
-    std::queue<std::string> m_sendQueue;
-    std::mutex m_sendMutex;
-    std::condition_variable m_sendCondition;
+    SendQueue m_sendQueue;
     ThreadManager::ThreadPool m_threadPool;
+    std::atomic<bool> m_disconnecting{false};
+    std::atomic<std::chrono::steady_clock::time_point> m_lastSend{};
+    std::atomic<int> m_runningWorkers{0};
 
-    bool SendRawMessage(const std::string& message);
+    bool SendRawMessage(const std::string& message, SendKind kind = SendKind::Control,
+                        SendProgress progress = nullptr);
+    bool EnqueueFramed(std::shared_ptr<const std::string> framed, SendKind kind, uint32_t vk = 0,
+                       SendProgress progress = nullptr);
     void SenderThreadLoop();
     void ReceiverThreadLoop();
+    void HandleConnectionLost();
 
 public:
     NetworkClient();
     ~NetworkClient();
-    bool Connect(const std::string& host, int port);
+    bool Connect(const std::string& host, int port, const ConnectTimeouts& timeouts = {},
+                 const std::function<bool()>& keepWaiting = nullptr, std::string_view opening = {});
     void Disconnect();
     bool IsConnected() const { return m_connectionState.IsConnected() && m_sslClient.IsConnected(); }
-    bool SendJsonMessage(const json& message);
+    bool SendJsonMessage(const json& message, SendKind kind = SendKind::Control,
+                         SendProgress progress = nullptr);
+    bool SendFramedMessage(std::shared_ptr<const std::string> framed, SendKind kind, uint32_t vk = 0);
+    static std::shared_ptr<const std::string> FrameMessage(const std::string& message);
     void SetMessageHandler(std::function<void(const std::string&)> handler);
     void SetDisconnectCallback(std::function<void()> callback);
     void StartReceiving();
+    static json ProtocolVersionMessage();
+    static json JoinChannelMessage(const std::string& channel, const std::string& connectionType = "master");
     bool SendProtocolVersion();
     bool SendJoinChannel(const std::string& channel, const std::string& connectionType = "master");
     bool SendBrailleInfo();
     bool SendKeyEvent(const json& keyEvent);
+    void SetSendQueueLimits(const SendQueueLimits& limits) { m_sendQueue.SetLimits(limits); }
+    SendQueueStats GetSendQueueStats() const { return m_sendQueue.GetStats(); }
+    void SetTlsResumption(bool enabled) { m_sslClient.SetResumption(enabled); }
+    bool TlsResumptionEnabled() const { return m_sslClient.ResumptionEnabled(); }
+    void SetTls13(bool enabled) { m_sslClient.SetTls13(enabled); }
+    bool Tls13Enabled() const { return m_sslClient.Tls13Enabled(); }
+    TlsConnectionInfo GetTlsInfo() const { return m_sslClient.GetConnectionInfo(); }
+    // When a message was last queued, or the connection opened if later.
+    std::chrono::steady_clock::time_point LastSendTime() const { return m_lastSend.load(); }
+    // Sender and receiver threads still running, including ones left over
+    // from a lost connection that Disconnect has not joined yet.
+    int RunningWorkers() const { return m_runningWorkers; }
 };
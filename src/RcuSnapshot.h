@@ -0,0 +1,79 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// Immutable value published through an atomic pointer. Readers never block:
+// Read() is one counter increment plus one pointer load. Writers serialize on
+// a mutex, copy the current value, and swap in the new one. Replaced values
+// are freed by the first writer that observes no reader in flight.
+template<typename T>
+class RcuSnapshot {
+private:
+    std::atomic<const T*> m_current;
+    std::atomic<uint32_t> m_readers{0};
+    std::mutex m_writeMutex;
+    std::vector<std::unique_ptr<const T>> m_retired;
+
+    void PublishLocked(std::unique_ptr<T> next) {
+        const T* old = m_current.exchange(next.release());
+        m_retired.emplace_back(old);
+        if (m_readers.load() == 0) {
+            m_retired.clear();
+        }
+    }
+
+public:
+    class ReadGuard {
+    private:
+        RcuSnapshot* m_owner;
+        const T* m_value;
+
+    public:
+        explicit ReadGuard(RcuSnapshot* owner) : m_owner(owner) {
+            m_owner->m_readers.fetch_add(1);
+            m_value = m_owner->m_current.load();
+        }
+
+        ~ReadGuard() {
+            if (m_owner) m_owner->m_readers.fetch_sub(1, std::memory_order_release);
+        }
+
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+        ReadGuard(ReadGuard&& other) noexcept : m_owner(other.m_owner), m_value(other.m_value) {
+            other.m_owner = nullptr;
+        }
+        ReadGuard& operator=(ReadGuard&&) = delete;
+
+        const T* operator->() const { return m_value; }
+        const T& operator*() const { return *m_value; }
+    };
+
+    RcuSnapshot() : m_current(new T()) {}
+
+    ~RcuSnapshot() {
+        delete m_current.load();
+    }
+
+    RcuSnapshot(const RcuSnapshot&) = delete;
+    RcuSnapshot& operator=(const RcuSnapshot&) = delete;
+
+    ReadGuard Read() { return ReadGuard(this); }
+
+    template<typename Mutator>
+    void Update(Mutator&& mutate) {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        auto next = std::make_unique<T>(*m_current.load());
+        mutate(*next);
+        PublishLocked(std::move(next));
+    }
+
+    void Publish(T value) {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        PublishLocked(std::make_unique<T>(std::move(value)));
+    }
+};
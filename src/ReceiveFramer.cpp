@@ -0,0 +1,36 @@
+#include "ReceiveFramer.h"
+#include <cstring>
+
+void ReceiveFramer::Emit(std::string_view line, const std::function<void(std::string_view)>& onMessage) {
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+    if (!line.empty()) onMessage(line);
+}
+
+void ReceiveFramer::Feed(const char* data, size_t length, const std::function<void(std::string_view)>& onMessage) {
+    const char* end = data + length;
+    while (data < end) {
+        const char* newline = static_cast<const char*>(std::memchr(data, '\n', end - data));
+        const size_t segment = (newline ? newline : end) - data;
+
+        if (m_discarding) {
+            if (newline) m_discarding = false;
+        } else if (m_buffer.size() + segment > m_maxMessageSize) {
+            m_buffer.clear();
+            m_discarding = !newline;
+            m_discarded++;
+        } else if (!newline) {
+            m_buffer.append(data, segment);
+        } else if (m_buffer.empty()) {
+            Emit(std::string_view(data, segment), onMessage);
+        } else {
+            m_buffer.append(data, segment);
+            Emit(m_buffer, onMessage);
+            m_buffer.clear();
+        }
+
+        if (m_buffer.empty() && m_buffer.capacity() > Config::RECEIVE_BUFFER_KEEP_BYTES) {
+            std::string().swap(m_buffer);
+        }
+        data += newline ? segment + 1 : segment;
+    }
+}
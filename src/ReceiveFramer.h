@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include "Config.h"
+
+// Splits the newline-delimited receive stream into messages. A line longer
+// than the limit is dropped and the framer resynchronises on the next
+// newline, so the buffer never holds more than maxMessageSize bytes. Lines
+// that arrive whole in one chunk are handed out without being copied.
+class ReceiveFramer {
+private:
+    std::string m_buffer;
+    size_t m_maxMessageSize;
+    bool m_discarding = false;
+    uint64_t m_discarded = 0;
+
+    void Emit(std::string_view line, const std::function<void(std::string_view)>& onMessage);
+
+public:
+    explicit ReceiveFramer(size_t maxMessageSize = Config::MAX_MESSAGE_SIZE)
+        : m_maxMessageSize(maxMessageSize) {}
+
+    void Feed(const char* data, size_t length, const std::function<void(std::string_view)>& onMessage);
+
+    size_t Buffered() const { return m_buffer.size(); }
+    uint64_t Discarded() const { return m_discarded; }
+};
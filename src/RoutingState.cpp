@@ -0,0 +1,3 @@
+#include "RoutingState.h"
+
+RcuSnapshot<RoutingSnapshot> RoutingState::s_snapshot;
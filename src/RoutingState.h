@@ -0,0 +1,33 @@
+#pragma once
+#include "RcuSnapshot.h"
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+class NetworkClient;
+
+struct RoutingSnapshot {
+    int activeProfile = -1;
+    bool forwardingKeys = false;
+    bool broadcasting = false;
+    std::vector<int> connectedProfiles;
+    std::vector<int> broadcastProfiles;
+    std::vector<std::string> profileNames;
+    std::vector<std::weak_ptr<NetworkClient>> clients;
+};
+
+class RoutingState {
+private:
+    static RcuSnapshot<RoutingSnapshot> s_snapshot;
+
+public:
+    using ReadGuard = RcuSnapshot<RoutingSnapshot>::ReadGuard;
+
+    static ReadGuard Read() { return s_snapshot.Read(); }
+
+    template<typename Mutator>
+    static void Update(Mutator&& mutate) {
+        s_snapshot.Update(std::forward<Mutator>(mutate));
+    }
+};
@@ -1,8 +1,12 @@
 #include "SSLClient.h"
 #include "Debug.h"
 #include "Config.h"
+#include "DnsCache.h"
+#include "TlsContext.h"
 #include <iostream>
 #include <cstring>
+#include <chrono>
+#include <vector>
 
 namespace {
     void LogSSLError(const std::string& operation, int ret) {
@@ -16,37 +20,19 @@ namespace {
 SSLClient::SSLClient() {
     mbedtls_net_init(&m_net_ctx);
     mbedtls_ssl_init(&m_ssl_ctx);
-    mbedtls_ssl_config_init(&m_ssl_conf);
-    mbedtls_entropy_init(&m_entropy);
-    mbedtls_ctr_drbg_init(&m_ctr_drbg);
+    mbedtls_ssl_session_init(&m_session);
 }
 
 SSLClient::~SSLClient() {
     Disconnect();
+    mbedtls_ssl_session_free(&m_session);
 }
 
 bool SSLClient::InitializeSSL() {
-    const char* pers = "ssl_client";
-    int ret = mbedtls_ctr_drbg_seed(&m_ctr_drbg, mbedtls_entropy_func, &m_entropy,
-                                    (const unsigned char*)pers, strlen(pers));
-    if (ret != 0) {
-        std::cerr << "Failed to seed RNG: " << ret << std::endl;
-        return false;
-    }
-
-    ret = mbedtls_ssl_config_defaults(&m_ssl_conf,
-                                      MBEDTLS_SSL_IS_CLIENT,
-                                      MBEDTLS_SSL_TRANSPORT_STREAM,
-                                      MBEDTLS_SSL_PRESET_DEFAULT);
-    if (ret != 0) {
-        std::cerr << "Failed to set SSL config defaults: " << ret << std::endl;
-        return false;
-    }
-
-    mbedtls_ssl_conf_authmode(&m_ssl_conf, MBEDTLS_SSL_VERIFY_NONE);
-    mbedtls_ssl_conf_rng(&m_ssl_conf, mbedtls_ctr_drbg_random, &m_ctr_drbg);
+    const mbedtls_ssl_config* conf = TlsContext::Get(m_tls13);
+    if (!conf) return false;
 
-    ret = mbedtls_ssl_setup(&m_ssl_ctx, &m_ssl_conf);
+    int ret = mbedtls_ssl_setup(&m_ssl_ctx, conf);
     if (ret != 0) {
         std::cerr << "Failed to setup SSL context: " << ret << std::endl;
         return false;
@@ -63,53 +49,182 @@ bool SSLClient::InitializeSSL() {
     return true;
 }
 
+// Frees everything and re-initialises, so the client can connect again.
 void SSLClient::CleanupSSL() {
     mbedtls_ssl_free(&m_ssl_ctx);
-    mbedtls_ssl_config_free(&m_ssl_conf);
-    mbedtls_ctr_drbg_free(&m_ctr_drbg);
-    mbedtls_entropy_free(&m_entropy);
     mbedtls_net_free(&m_net_ctx);
+
+    mbedtls_net_init(&m_net_ctx);
+    mbedtls_ssl_init(&m_ssl_ctx);
 }
 
-bool SSLClient::Connect(const std::string& host, int port) {
+// Each phase gets its own deadline from timeouts; keepWaiting is polled
+// throughout so shutdown can abandon the attempt from another thread.
+bool SSLClient::Connect(const std::string& host, int port, const ConnectTimeouts& timeouts,
+                        const std::function<bool()>& keepWaiting, std::string_view opening) {
     if (!m_connectionState.AttemptTransition(ConnectionState::Status::Disconnected, ConnectionState::Status::Connecting)) {
         return false;
     }
     
     m_serverName = host;
-    
-    int ret = mbedtls_net_connect(&m_net_ctx, host.c_str(), std::to_string(port).c_str(),
-                                  MBEDTLS_NET_PROTO_TCP);
-    if (ret != 0) {
-        LogSSLError("Failed to connect TCP", ret);
+    auto phaseDeadline = [](int ms) {
+        return TcpConnector::Clock::now() + std::chrono::milliseconds(ms);
+    };
+
+    std::vector<ResolvedAddress> addresses;
+    ConnectStatus status = DnsCache::Resolve(host, port, phaseDeadline(timeouts.dnsMs), keepWaiting, addresses);
+    if (status != ConnectStatus::Ok) {
+        std::cerr << "Failed to resolve " << host << ": " << DescribeConnectStatus(status) << std::endl;
+        m_connectionState.TransitionTo(ConnectionState::Status::Disconnected);
+        return false;
+    }
+
+    int fd = -1;
+    status = TcpConnector::Connect(host, addresses, phaseDeadline(timeouts.tcpMs), keepWaiting, fd);
+    if (status != ConnectStatus::Ok) {
+        if (status != ConnectStatus::Cancelled) DnsCache::Refresh(host, port);
+        std::cerr << "Failed to connect TCP to " << host << ":" << port << ": "
+                  << DescribeConnectStatus(status) << std::endl;
         m_connectionState.TransitionTo(ConnectionState::Status::Disconnected);
         return false;
     }
 
     DEBUG_INFO_F("SSL", "TCP connection established to {}:{}", host, port);
 
+    m_net_ctx.fd = fd;
     mbedtls_net_set_nonblock(&m_net_ctx);
 
     if (!InitializeSSL()) {
-        mbedtls_net_free(&m_net_ctx);
+        CleanupSSL();
         m_connectionState.TransitionTo(ConnectionState::Status::Disconnected);
         return false;
     }
 
-    while ((ret = mbedtls_ssl_handshake(&m_ssl_ctx)) != 0) {
-        if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
-            LogSSLError("SSL handshake failed", ret);
+    auto tlsDeadline = phaseDeadline(timeouts.tlsMs);
+    std::string server = host + ":" + std::to_string(port);
+    size_t early = 0;
+    status = ConnectStatus::Ok;
+    if (RestoreSession(server) && !opening.empty()) {
+        status = WriteEarlyData(opening, tlsDeadline, keepWaiting, early);
+    }
+    if (status == ConnectStatus::Ok) status = Handshake(tlsDeadline, keepWaiting);
+    if (status != ConnectStatus::Ok) {
+        CleanupSSL();
+        m_connectionState.TransitionTo(ConnectionState::Status::Disconnected);
+        return false;
+    }
+
+#if defined(MBEDTLS_SSL_EARLY_DATA)
+    if (early > 0 && mbedtls_ssl_get_early_data_status(&m_ssl_ctx) != MBEDTLS_SSL_EARLY_DATA_STATUS_ACCEPTED) {
+        DEBUG_INFO("SSL", "Server rejected early data, resending after the handshake");
+        early = 0;
+    }
+#endif
+    const char* version = mbedtls_ssl_get_version(&m_ssl_ctx);
+    const char* ciphersuite = mbedtls_ssl_get_ciphersuite(&m_ssl_ctx);
+    m_version = version ? version : "";
+    m_ciphersuite = ciphersuite ? ciphersuite : "";
+    m_maxInRecord = mbedtls_ssl_get_max_in_record_payload(&m_ssl_ctx);
+    m_maxOutRecord = static_cast<int>(mbedtls_ssl_get_max_out_record_payload(&m_ssl_ctx));
+    DEBUG_INFO_F("SSL", "SSL handshake completed: {} {}, record limits in {} out {}, {} bytes of early data",
+                 m_version.load(), m_ciphersuite.load(), m_maxInRecord.load(), m_maxOutRecord.load(), early);
+    m_connectionState.TransitionTo(ConnectionState::Status::Connected);
+
+    // TLS 1.2 sessions can be saved now; TLS 1.3 tickets arrive later, in Receive.
+    m_sessionServer = server;
+    if (m_resumption && mbedtls_ssl_get_version_number(&m_ssl_ctx) == MBEDTLS_SSL_VERSION_TLS1_2) {
+        SaveSession();
+    }
+
+    if (early < opening.size()) {
+        auto keepSending = [&keepWaiting] { return !keepWaiting || keepWaiting(); };
+        if (SendAll(opening.data() + early, static_cast<int>(opening.size() - early), keepSending) < 0) {
             CleanupSSL();
             m_connectionState.TransitionTo(ConnectionState::Status::Disconnected);
             return false;
         }
     }
-
-    DEBUG_INFO("SSL", "SSL handshake completed successfully");
-    m_connectionState.TransitionTo(ConnectionState::Status::Connected);
     return true;
 }
 
+// Sessions are kept only for resumption-enabled clients and used once: TLS
+// 1.3 tickets are single-use, and the server sends fresh ones every time.
+bool SSLClient::RestoreSession(const std::string& server) {
+    bool usable = m_resumption && m_haveSession && m_sessionServer == server;
+    bool restored = usable && mbedtls_ssl_set_session(&m_ssl_ctx, &m_session) == 0;
+    DropSession();
+    if (restored) DEBUG_VERBOSE_F("SSL", "Resuming TLS session with {}", server);
+    return restored;
+}
+
+void SSLClient::SaveSession() {
+    DropSession();
+    m_haveSession = mbedtls_ssl_get_session(&m_ssl_ctx, &m_session) == 0;
+}
+
+void SSLClient::DropSession() {
+    mbedtls_ssl_session_free(&m_session);
+    mbedtls_ssl_session_init(&m_session);
+    m_haveSession = false;
+}
+
+// Writes as much of data as the server's ticket allows into the ClientHello
+// flight. Stopping short is not an error: the rest is sent after the handshake.
+ConnectStatus SSLClient::WriteEarlyData(std::string_view data, TcpConnector::Clock::time_point deadline,
+                                        const std::function<bool()>& keepWaiting, size_t& written) {
+    written = 0;
+#if defined(MBEDTLS_SSL_EARLY_DATA)
+    while (written < data.size()) {
+        int ret = mbedtls_ssl_write_early_data(&m_ssl_ctx, (const unsigned char*)data.data() + written,
+                                               data.size() - written);
+        if (ret > 0) {
+            written += static_cast<size_t>(ret);
+            continue;
+        }
+        if (ret == 0 || ret == MBEDTLS_ERR_SSL_CANNOT_WRITE_EARLY_DATA) break;
+        ConnectStatus status = WaitForIo(ret, "SSL early data", deadline, keepWaiting);
+        if (status != ConnectStatus::Ok) return status;
+    }
+#endif
+    return ConnectStatus::Ok;
+}
+
+ConnectStatus SSLClient::Handshake(TcpConnector::Clock::time_point deadline, const std::function<bool()>& keepWaiting) {
+    int ret;
+    while ((ret = mbedtls_ssl_handshake(&m_ssl_ctx)) != 0) {
+        ConnectStatus status = WaitForIo(ret, "SSL handshake", deadline, keepWaiting);
+        if (status != ConnectStatus::Ok) return status;
+    }
+    return ConnectStatus::Ok;
+}
+
+// Waits for the socket after a WANT_READ/WANT_WRITE during the handshake.
+// Returns Ok when the caller should retry the operation.
+ConnectStatus SSLClient::WaitForIo(int ret, const char* operation, TcpConnector::Clock::time_point deadline,
+                                   const std::function<bool()>& keepWaiting) {
+    if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+        LogSSLError(std::string(operation) + " failed", ret);
+        return ConnectStatus::Failed;
+    }
+
+    ConnectStatus status = ConnectStatus::Ok;
+    if (keepWaiting && !keepWaiting()) status = ConnectStatus::Cancelled;
+    else if (TcpConnector::Clock::now() >= deadline) status = ConnectStatus::TimedOut;
+    if (status != ConnectStatus::Ok) {
+        std::cerr << operation << " " << DescribeConnectStatus(status) << std::endl;
+        DEBUG_ERROR_F("SSL", "{} {}", operation, DescribeConnectStatus(status));
+        return status;
+    }
+
+    uint32_t want = ret == MBEDTLS_ERR_SSL_WANT_READ ? MBEDTLS_NET_POLL_READ : MBEDTLS_NET_POLL_WRITE;
+    int ready = mbedtls_net_poll(&m_net_ctx, want, Config::CONNECT_POLL_INTERVAL_MS);
+    if (ready < 0) {
+        LogSSLError("Socket poll failed", ready);
+        return ConnectStatus::Failed;
+    }
+    return ConnectStatus::Ok;
+}
+
 void SSLClient::Disconnect() {
     DEBUG_VERBOSE("SSL", "Starting SSL disconnect");
     m_connectionState.TransitionTo(ConnectionState::Status::Disconnecting);
@@ -122,12 +237,6 @@ void SSLClient::Disconnect() {
     DEBUG_VERBOSE("SSL", "Cleaning up SSL resources");
     CleanupSSL();
 
-    mbedtls_net_init(&m_net_ctx);
-    mbedtls_ssl_init(&m_ssl_ctx);
-    mbedtls_ssl_config_init(&m_ssl_conf);
-    mbedtls_entropy_init(&m_entropy);
-    mbedtls_ctr_drbg_init(&m_ctr_drbg);
-
     m_connectionState.TransitionTo(ConnectionState::Status::Disconnected);
     DEBUG_VERBOSE("SSL", "SSL disconnect completed");
 }
@@ -143,15 +252,56 @@ int SSLClient::Send(const char* data, int length) {
 
     int ret = mbedtls_ssl_write(&m_ssl_ctx, (const unsigned char*)data, length);
     if (ret < 0) {
-        if (ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
-            m_connectionState.TransitionTo(ConnectionState::Status::Disconnected);
+        if (ret == MBEDTLS_ERR_SSL_WANT_WRITE || ret == MBEDTLS_ERR_SSL_WANT_READ) {
+            return ret;
         }
+        LogSSLError("SSL write failed", ret);
+        m_connectionState.TransitionTo(ConnectionState::Status::Disconnected);
         return -1;
     }
 
     return ret;
 }
 
+// mbedtls_ssl_write may accept only part of the buffer, and after WANT_WRITE
+// it must be called again with the same pointer and length until it succeeds.
+int SSLClient::SendAll(const char* data, int length, const std::function<bool()>& keepWaiting) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(Config::SEND_STALL_TIMEOUT_MS);
+    int sent = 0;
+
+    while (sent < length) {
+        int ret = Send(data + sent, length - sent);
+        if (ret > 0) {
+            sent += ret;
+            if (sent < length) {
+                DEBUG_TRACE_F("SSL", "Partial write: {} of {} bytes", sent, length);
+            }
+            deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(Config::SEND_STALL_TIMEOUT_MS);
+            continue;
+        }
+        if ((ret != MBEDTLS_ERR_SSL_WANT_WRITE && ret != MBEDTLS_ERR_SSL_WANT_READ) || !keepWaiting()) return -1;
+
+        if (std::chrono::steady_clock::now() >= deadline) {
+            DEBUG_ERROR_F("SSL", "Send stalled for {} ms with {} of {} bytes written",
+                          Config::SEND_STALL_TIMEOUT_MS, sent, length);
+            m_connectionState.TransitionTo(ConnectionState::Status::Disconnected);
+            return -1;
+        }
+
+        // A write can need to read first, e.g. while TLS 1.3 post-handshake
+        // messages are in flight, so wait in the direction Mbed TLS asked for.
+        uint32_t want = ret == MBEDTLS_ERR_SSL_WANT_READ ? MBEDTLS_NET_POLL_READ : MBEDTLS_NET_POLL_WRITE;
+        int ready = mbedtls_net_poll(&m_net_ctx, want, Config::SEND_POLL_INTERVAL_MS);
+        if (ready < 0) {
+            LogSSLError("Socket poll failed", ready);
+            m_connectionState.TransitionTo(ConnectionState::Status::Disconnected);
+            return -1;
+        }
+    }
+
+    return sent;
+}
+
 int SSLClient::Receive(char* buffer, int bufferSize) {
     if (!IsConnected()) {
         return -1;
@@ -159,6 +309,10 @@ int SSLClient::Receive(char* buffer, int bufferSize) {
 
     int ret = mbedtls_ssl_read(&m_ssl_ctx, (unsigned char*)buffer, bufferSize);
     if (ret < 0) {
+        if (ret == MBEDTLS_ERR_SSL_RECEIVED_NEW_SESSION_TICKET) {
+            if (m_resumption) SaveSession();
+            return -2;
+        }
         if (ret == MBEDTLS_ERR_SSL_WANT_READ) {
             return -2;
         } else {
@@ -1,34 +1,74 @@
 #pragma once
 #include <string>
+#include <string_view>
+#include <functional>
+#include <atomic>
 #include <mbedtls/net_sockets.h>
 #include <mbedtls/ssl.h>
-#include <mbedtls/entropy.h>
-#include <mbedtls/ctr_drbg.h>
 #include <mbedtls/error.h>
 #include "ConnectionState.h"
+#include "TcpConnector.h"
+
+// What the last handshake negotiated. The strings point into Mbed TLS's
+// static tables.
+struct TlsConnectionInfo {
+    const char* version = "";
+    const char* ciphersuite = "";
+    int maxInRecord = 0;
+    int maxOutRecord = 0;
+};
 
 class SSLClient {
 private:
     mbedtls_net_context m_net_ctx;
     mbedtls_ssl_context m_ssl_ctx;
-    mbedtls_ssl_config m_ssl_conf;
-    mbedtls_entropy_context m_entropy;
-    mbedtls_ctr_drbg_context m_ctr_drbg;
     std::string m_serverName;
     ConnectionState::StateManager m_connectionState;
+    std::atomic<const char*> m_version{""};
+    std::atomic<const char*> m_ciphersuite{""};
+    std::atomic<int> m_maxInRecord{0};
+    std::atomic<int> m_maxOutRecord{0};
+    std::atomic<bool> m_resumption{false};
+    std::atomic<bool> m_tls13{false};
+    mbedtls_ssl_session m_session;
+    bool m_haveSession = false;
+    std::string m_sessionServer;
 
 public:
     SSLClient();
     ~SSLClient();
     
-    bool Connect(const std::string& host, int port);
+    // opening is written before anything else: as TLS 1.3 early data when a
+    // resumed session allows it, otherwise right after the handshake.
+    bool Connect(const std::string& host, int port, const ConnectTimeouts& timeouts = {},
+                 const std::function<bool()>& keepWaiting = nullptr, std::string_view opening = {});
     void Disconnect();
     bool IsConnected() const;
+    // Keeps the server's session tickets and resumes with them on reconnect.
+    void SetResumption(bool enabled) { m_resumption = enabled; }
+    bool ResumptionEnabled() const { return m_resumption; }
+    // Offers TLS 1.3, and early data with it, from the next Connect.
+    void SetTls13(bool enabled) { m_tls13 = enabled; }
+    bool Tls13Enabled() const { return m_tls13; }
+    TlsConnectionInfo GetConnectionInfo() const {
+        return {m_version.load(), m_ciphersuite.load(), m_maxInRecord.load(), m_maxOutRecord.load()};
+    }
     
+    // Returns the bytes written, MBEDTLS_ERR_SSL_WANT_WRITE or WANT_READ when
+    // the socket must become ready in that direction first, or -1 on failure.
     int Send(const char* data, int length);
+    int SendAll(const char* data, int length, const std::function<bool()>& keepWaiting);
     int Receive(char* buffer, int bufferSize);
     
 private:
     bool InitializeSSL();
     void CleanupSSL();
+    ConnectStatus Handshake(TcpConnector::Clock::time_point deadline, const std::function<bool()>& keepWaiting);
+    ConnectStatus WriteEarlyData(std::string_view data, TcpConnector::Clock::time_point deadline,
+                                 const std::function<bool()>& keepWaiting, size_t& written);
+    ConnectStatus WaitForIo(int ret, const char* operation, TcpConnector::Clock::time_point deadline,
+                            const std::function<bool()>& keepWaiting);
+    bool RestoreSession(const std::string& server);
+    void SaveSession();
+    void DropSession();
 };
\ No newline at end of file
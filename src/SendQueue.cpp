@@ -0,0 +1,177 @@
+#include "SendQueue.h"
+#include "Debug.h"
+#include <chrono>
+
+void SendQueue::SetLimits(const SendQueueLimits& limits) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_limits = limits;
+    m_space.notify_all();
+}
+
+void SendQueue::Open() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+    m_stats.bytes = 0;
+    m_keyDown.reset();
+    m_keyRefused.reset();
+    m_open = true;
+}
+
+void SendQueue::Close() {
+    size_t cleared;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        cleared = m_entries.size();
+        m_entries.clear();
+        m_stats.bytes = 0;
+        m_open = false;
+    }
+    m_available.notify_all();
+    m_space.notify_all();
+    if (cleared > 0) {
+        DEBUG_VERBOSE_F("NETWORK", "Cleared {} unsent messages from queue", cleared);
+    }
+}
+
+bool SendQueue::IsFull(size_t incomingBytes) const {
+    return m_entries.size() >= m_limits.maxMessages ||
+           m_stats.bytes + incomingBytes > m_limits.maxBytes;
+}
+
+bool SendQueue::UnderPressure() const {
+    return m_entries.size() * 2 >= m_limits.maxMessages;
+}
+
+void SendQueue::Append(std::shared_ptr<const std::string> data, SendKind kind, uint32_t vk, bool repeat,
+                       SendProgress progress) {
+    m_stats.bytes += data->size();
+    m_entries.push_back({std::move(data), kind, vk, repeat, std::move(progress)});
+    if (m_entries.size() > m_stats.highWaterMessages) m_stats.highWaterMessages = m_entries.size();
+    if (m_stats.bytes > m_stats.highWaterBytes) m_stats.highWaterBytes = m_stats.bytes;
+    m_available.notify_one();
+}
+
+void SendQueue::RemoveAt(size_t index) {
+    m_stats.bytes -= m_entries[index].data->size();
+    m_entries.erase(m_entries.begin() + static_cast<std::ptrdiff_t>(index));
+    m_space.notify_all();
+}
+
+bool SendQueue::EvictOldestRepeat(uint32_t vk) {
+    for (size_t i = 0; i < m_entries.size(); i++) {
+        const auto& e = m_entries[i];
+        if (e.repeat && (vk == UINT32_MAX || e.vk == vk)) {
+            RemoveAt(i);
+            m_stats.dropped++;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Only the most recent key event may be cancelled. With other keys queued
+// after the press, dropping it would change what they combine with: Ctrl
+// down, W down, W up, Ctrl up must not reach the remote as Ctrl alone plus w.
+bool SendQueue::CollapseRelease(uint32_t vk) {
+    size_t press = m_entries.size();
+    for (size_t i = m_entries.size(); i-- > 0;) {
+        const auto& e = m_entries[i];
+        bool keyEvent = e.kind == SendKind::KeyPress || e.kind == SendKind::KeyRelease;
+        if (!keyEvent) continue;
+        if (e.vk != vk) break;
+        if (e.kind == SendKind::KeyPress && !e.repeat) {
+            press = i;
+            break;
+        }
+    }
+
+    if (press == m_entries.size()) {
+        while (EvictOldestRepeat(vk)) {}
+        return false;
+    }
+
+    for (size_t i = m_entries.size(); i-- > press;) {
+        if (m_entries[i].kind == SendKind::KeyPress && m_entries[i].vk == vk) {
+            RemoveAt(i);
+        }
+    }
+    m_stats.collapsed++;
+    return true;
+}
+
+bool SendQueue::Push(std::shared_ptr<const std::string> data, SendKind kind, uint32_t vk,
+                     SendProgress progress) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_open) return false;
+
+    const size_t size = data->size();
+    const bool tracked = vk < TRACKED_KEYS &&
+                         (kind == SendKind::KeyPress || kind == SendKind::KeyRelease);
+
+    if (kind == SendKind::KeyRelease && tracked) {
+        if (m_keyRefused[vk]) {
+            m_keyRefused[vk] = false;
+            m_keyDown[vk] = false;
+            return false;
+        }
+        bool wasDown = m_keyDown[vk];
+        m_keyDown[vk] = false;
+        if (wasDown && UnderPressure() && CollapseRelease(vk)) {
+            DEBUG_VERBOSE_F("NETWORK", "Collapsed queued press/release for VK={}", vk);
+            return true;
+        }
+        Append(std::move(data), kind, vk, false);
+        return true;
+    }
+
+    const bool repeat = kind == SendKind::KeyPress && tracked && m_keyDown[vk];
+    if (repeat && UnderPressure()) {
+        EvictOldestRepeat(vk);
+    }
+
+    while (IsFull(size) && EvictOldestRepeat()) {}
+
+    if (IsFull(size) && kind == SendKind::Clipboard &&
+        m_limits.clipboardPolicy == OverflowPolicy::Block && size <= m_limits.maxBytes) {
+        DEBUG_VERBOSE("NETWORK", "Send queue full, waiting to queue clipboard text");
+        m_space.wait_for(lock, std::chrono::milliseconds(m_limits.blockTimeoutMs), [&] {
+            return !m_open || !IsFull(size);
+        });
+        if (!m_open) return false;
+    }
+
+    if (IsFull(size)) {
+        m_stats.refused++;
+        if (kind == SendKind::KeyPress && tracked && !repeat) m_keyRefused[vk] = true;
+        DEBUG_WARN_F("NETWORK", "Send queue full ({} messages, {} bytes), refusing message",
+                     m_entries.size(), m_stats.bytes);
+        return false;
+    }
+
+    Append(std::move(data), kind, vk, repeat, std::move(progress));
+    if (kind == SendKind::KeyPress && tracked) {
+        m_keyDown[vk] = true;
+        m_keyRefused[vk] = false;
+    }
+    return true;
+}
+
+bool SendQueue::WaitPop(std::shared_ptr<const std::string>& out, SendProgress* progress) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_available.wait(lock, [this] { return !m_open || !m_entries.empty(); });
+    if (!m_open) return false;
+
+    if (progress) *progress = std::move(m_entries.front().progress);
+    out = std::move(m_entries.front().data);
+    m_stats.bytes -= out->size();
+    m_entries.pop_front();
+    m_space.notify_all();
+    return true;
+}
+
+SendQueueStats SendQueue::GetStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    SendQueueStats stats = m_stats;
+    stats.depth = m_entries.size();
+    return stats;
+}
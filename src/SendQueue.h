@@ -0,0 +1,90 @@
+#pragma once
+#include <bitset>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "Config.h"
+
+enum class SendKind : uint8_t {
+    Control,
+    KeyPress,
+    KeyRelease,
+    Clipboard
+};
+
+enum class OverflowPolicy : uint8_t {
+    Refuse,
+    Block
+};
+
+// Called by the sender after each slice of a message has been written.
+using SendProgress = std::function<void(size_t sent, size_t total)>;
+
+struct SendQueueLimits {
+    size_t maxMessages = Config::SEND_QUEUE_MAX_MESSAGES;
+    size_t maxBytes = Config::SEND_QUEUE_MAX_BYTES;
+    OverflowPolicy clipboardPolicy = OverflowPolicy::Refuse;
+    int blockTimeoutMs = Config::SEND_QUEUE_BLOCK_TIMEOUT_MS;
+};
+
+struct SendQueueStats {
+    size_t depth = 0;
+    size_t bytes = 0;
+    size_t highWaterMessages = 0;
+    size_t highWaterBytes = 0;
+    uint64_t dropped = 0;
+    uint64_t collapsed = 0;
+    uint64_t refused = 0;
+};
+
+// Bounded outgoing message queue. Once the queue is half full, key repeats
+// replace older queued repeats of the same key, and a release whose press is
+// the last key event queued cancels both. When full, the oldest queued repeat
+// is evicted to make room. Releases of tracked keys (VK codes below 256) are
+// always accepted so the remote never sees a stuck key; releases of other
+// codes count against the limits like any message. Clipboard pushes are
+// refused or block, depending on the policy.
+class SendQueue {
+private:
+    struct Entry {
+        std::shared_ptr<const std::string> data;
+        SendKind kind;
+        uint32_t vk;
+        bool repeat;
+        SendProgress progress;
+    };
+
+    static constexpr size_t TRACKED_KEYS = 256;
+
+    std::deque<Entry> m_entries;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_available;
+    std::condition_variable m_space;
+    SendQueueLimits m_limits;
+    SendQueueStats m_stats;
+    std::bitset<TRACKED_KEYS> m_keyDown;
+    std::bitset<TRACKED_KEYS> m_keyRefused;
+    bool m_open = false;
+
+    bool IsFull(size_t incomingBytes) const;
+    bool UnderPressure() const;
+    bool EvictOldestRepeat(uint32_t vk = UINT32_MAX);
+    bool CollapseRelease(uint32_t vk);
+    void Append(std::shared_ptr<const std::string> data, SendKind kind, uint32_t vk, bool repeat,
+                SendProgress progress = nullptr);
+    void RemoveAt(size_t index);
+
+public:
+    void SetLimits(const SendQueueLimits& limits);
+    void Open();
+    void Close();
+
+    bool Push(std::shared_ptr<const std::string> data, SendKind kind, uint32_t vk = 0,
+              SendProgress progress = nullptr);
+    bool WaitPop(std::shared_ptr<const std::string>& out, SendProgress* progress = nullptr);
+    SendQueueStats GetStats() const;
+};
@@ -0,0 +1,131 @@
+#include "SpeechQueue.h"
+#include "Speech.h"
+#include "Debug.h"
+
+std::mutex SpeechQueue::s_mutex;
+std::condition_variable SpeechQueue::s_cv;
+std::deque<SpeechQueue::Utterance> SpeechQueue::s_queue;
+std::thread SpeechQueue::s_worker;
+bool SpeechQueue::s_running = false;
+bool SpeechQueue::s_stopPending = false;
+SpeechQueueStats SpeechQueue::s_stats;
+double SpeechQueue::s_totalLatencyMs = 0.0;
+std::function<void(std::string_view, bool)> SpeechQueue::s_speak;
+std::function<void()> SpeechQueue::s_stop;
+
+void SpeechQueue::SetBackend(std::function<void(std::string_view, bool)> speak, std::function<void()> stop) {
+    s_speak = std::move(speak);
+    s_stop = std::move(stop);
+}
+
+void SpeechQueue::Speak(std::string_view text, bool interrupt) {
+    if (s_speak) s_speak(text, interrupt);
+    else Speech::Speak(text, interrupt);
+}
+
+void SpeechQueue::Stop() {
+    if (s_stop) s_stop();
+    else Speech::Stop();
+}
+
+void SpeechQueue::Start() {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (s_running) return;
+    s_running = true;
+    s_worker = std::thread(WorkerLoop);
+    DEBUG_VERBOSE("SPEECH", "Speech worker started");
+}
+
+void SpeechQueue::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        if (!s_running) return;
+        s_running = false;
+        s_queue.clear();
+    }
+    s_cv.notify_all();
+    if (s_worker.joinable()) s_worker.join();
+    DEBUG_VERBOSE("SPEECH", "Speech worker stopped");
+}
+
+void SpeechQueue::Enqueue(std::string_view text, bool interrupt) {
+    if (text.empty()) return;
+
+    std::unique_lock<std::mutex> lock(s_mutex);
+    if (!s_running) {
+        lock.unlock();
+        Speak(text, interrupt);
+        return;
+    }
+
+    if (interrupt) {
+        s_stats.cancelled += s_queue.size();
+        s_queue.clear();
+    }
+
+    if (!interrupt && !s_queue.empty()) {
+        auto& last = s_queue.back();
+        last.text.reserve(last.text.size() + 1 + text.size());
+        last.text += ' ';
+        last.text.append(text);
+        s_stats.merged++;
+    } else {
+        s_queue.push_back({std::string(text), interrupt, std::chrono::steady_clock::now()});
+        if (s_queue.size() > s_stats.peakDepth) s_stats.peakDepth = s_queue.size();
+    }
+    lock.unlock();
+    s_cv.notify_one();
+}
+
+void SpeechQueue::Cancel() {
+    std::unique_lock<std::mutex> lock(s_mutex);
+    if (!s_running) {
+        lock.unlock();
+        Stop();
+        return;
+    }
+    s_stats.cancelled += s_queue.size();
+    s_queue.clear();
+    s_stopPending = true;
+    lock.unlock();
+    s_cv.notify_one();
+}
+
+SpeechQueueStats SpeechQueue::GetStats() {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    SpeechQueueStats stats = s_stats;
+    stats.depth = s_queue.size();
+    return stats;
+}
+
+void SpeechQueue::WorkerLoop() {
+    while (true) {
+        Utterance next;
+        bool stop;
+        {
+            std::unique_lock<std::mutex> lock(s_mutex);
+            s_cv.wait(lock, [] { return !s_running || s_stopPending || !s_queue.empty(); });
+            if (!s_running) return;
+
+            stop = s_stopPending;
+            s_stopPending = false;
+            if (s_queue.empty()) {
+                next.text.clear();
+            } else {
+                next = std::move(s_queue.front());
+                s_queue.pop_front();
+
+                double latency = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - next.queuedAt).count();
+                s_stats.spoken++;
+                s_stats.lastLatencyMs = latency;
+                if (latency > s_stats.maxLatencyMs) s_stats.maxLatencyMs = latency;
+                s_totalLatencyMs += latency;
+                s_stats.avgLatencyMs = s_totalLatencyMs / static_cast<double>(s_stats.spoken);
+            }
+        }
+
+        if (stop) Stop();
+        if (!next.text.empty()) Speak(next.text, next.interrupt);
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+struct SpeechQueueStats {
+    size_t depth = 0;
+    size_t peakDepth = 0;
+    uint64_t spoken = 0;
+    uint64_t merged = 0;
+    uint64_t cancelled = 0;
+    double lastLatencyMs = 0.0;
+    double maxLatencyMs = 0.0;
+    double avgLatencyMs = 0.0;
+};
+
+// Speaks remote speech on a dedicated worker so a slow TTS backend never
+// stalls the network receive path. Consecutive non-interrupting utterances
+// that are still waiting are merged into one; Cancel() drops everything
+// queued and stops the current utterance.
+class SpeechQueue {
+private:
+    struct Utterance {
+        std::string text;
+        bool interrupt;
+        std::chrono::steady_clock::time_point queuedAt;
+    };
+
+    static std::mutex s_mutex;
+    static std::condition_variable s_cv;
+    static std::deque<Utterance> s_queue;
+    static std::thread s_worker;
+    static bool s_running;
+    static bool s_stopPending;
+    static SpeechQueueStats s_stats;
+    static double s_totalLatencyMs;
+    static std::function<void(std::string_view, bool)> s_speak;
+    static std::function<void()> s_stop;
+
+    static void WorkerLoop();
+    static void Speak(std::string_view text, bool interrupt);
+    static void Stop();
+
+public:
+    static void Start();
+    static void Shutdown();
+
+    static void Enqueue(std::string_view text, bool interrupt = false);
+    static void Cancel();
+    static SpeechQueueStats GetStats();
+
+    // Replaces Speech::Speak and Speech::Stop, for tests. Empty functions
+    // restore them. Only call while the queue is stopped.
+    static void SetBackend(std::function<void(std::string_view text, bool interrupt)> speak,
+                           std::function<void()> stop);
+};
@@ -0,0 +1,331 @@
+#include "TcpConnector.h"
+#include "Debug.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(sockaddr_storage) <= sizeof(ResolvedAddress::addr), "ResolvedAddress too small");
+
+namespace {
+    using Clock = TcpConnector::Clock;
+
+    // Time left before the deadline, capped at one poll interval so the
+    // caller gets to check keepWaiting between waits.
+    int NextWaitMs(Clock::time_point deadline) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+        return static_cast<int>(std::clamp<long long>(left, 0, Config::CONNECT_POLL_INTERVAL_MS));
+    }
+
+    bool Cancelled(const std::function<bool()>& keepWaiting) {
+        return keepWaiting && !keepWaiting();
+    }
+
+#ifdef _WIN32
+    void EnsureWinsock() {
+        static std::once_flag once;
+        std::call_once(once, [] {
+            WSADATA data;
+            WSAStartup(MAKEWORD(2, 2), &data);
+        });
+    }
+
+    bool SetNonBlocking(SOCKET s) {
+        u_long mode = 1;
+        return ioctlsocket(s, FIONBIO, &mode) == 0;
+    }
+
+    bool ConnectInProgress() {
+        return WSAGetLastError() == WSAEWOULDBLOCK;
+    }
+
+    // WSAPoll misses failed connects on older Windows, so select() it is.
+    int WaitWritable(const std::vector<int>& fds, int timeoutMs, std::vector<bool>& ready) {
+        fd_set writeSet, errorSet;
+        FD_ZERO(&writeSet);
+        FD_ZERO(&errorSet);
+        for (int fd : fds) {
+            FD_SET(static_cast<SOCKET>(fd), &writeSet);
+            FD_SET(static_cast<SOCKET>(fd), &errorSet);
+        }
+        timeval tv{timeoutMs / 1000, (timeoutMs % 1000) * 1000};
+        int ret = select(0, nullptr, &writeSet, &errorSet, &tv);
+        ready.assign(fds.size(), false);
+        for (size_t i = 0; ret > 0 && i < fds.size(); ++i) {
+            auto s = static_cast<SOCKET>(fds[i]);
+            ready[i] = FD_ISSET(s, &writeSet) || FD_ISSET(s, &errorSet);
+        }
+        return ret;
+    }
+#else
+    void EnsureWinsock() {}
+
+    bool SetNonBlocking(int fd) {
+        int flags = fcntl(fd, F_GETFL, 0);
+        return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+    }
+
+    bool ConnectInProgress() {
+        return errno == EINPROGRESS;
+    }
+
+    int WaitWritable(const std::vector<int>& fds, int timeoutMs, std::vector<bool>& ready) {
+        std::vector<pollfd> pfds;
+        for (int fd : fds) pfds.push_back({fd, POLLOUT, 0});
+        int ret = poll(pfds.data(), static_cast<nfds_t>(pfds.size()), timeoutMs);
+        ready.assign(fds.size(), false);
+        for (size_t i = 0; ret > 0 && i < fds.size(); ++i) ready[i] = pfds[i].revents != 0;
+        return ret < 0 && errno == EINTR ? 0 : ret;
+    }
+#endif
+
+    int SocketError(int fd) {
+        int error = 0;
+        socklen_t length = sizeof(error);
+        if (getsockopt(fd, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&error), &length) != 0) return -1;
+        return error;
+    }
+
+    // Starts a non-blocking connect. Returns -1 if it failed outright;
+    // connected is set when it completed immediately.
+    int StartAttempt(const ResolvedAddress& address, bool& connected) {
+        connected = false;
+        auto s = socket(address.family, SOCK_STREAM, IPPROTO_TCP);
+#ifdef _WIN32
+        if (s == INVALID_SOCKET) return -1;
+#else
+        if (s < 0) return -1;
+#endif
+        int fd = static_cast<int>(s);
+        if (!SetNonBlocking(s)) {
+            TcpConnector::Close(fd);
+            return -1;
+        }
+        const auto* sa = reinterpret_cast<const sockaddr*>(address.addr.data());
+        if (connect(s, sa, static_cast<socklen_t>(address.length)) == 0) {
+            connected = true;
+            return fd;
+        }
+        if (!ConnectInProgress()) {
+            TcpConnector::Close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    struct Attempt {
+        int fd;
+        int family;
+    };
+
+    struct Lookup {
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool done = false;
+        bool abandoned = false;
+        int error = 0;
+        addrinfo* result = nullptr;
+    };
+}
+
+std::mutex TcpConnector::s_mutex;
+std::unordered_map<std::string, int> TcpConnector::s_preferredFamily;
+TcpConnector::Resolver TcpConnector::s_resolver;
+
+const char* DescribeConnectStatus(ConnectStatus status) {
+    switch (status) {
+        case ConnectStatus::Ok:        return "ok";
+        case ConnectStatus::Failed:    return "failed";
+        case ConnectStatus::TimedOut:  return "timed out";
+        case ConnectStatus::Cancelled: return "cancelled";
+    }
+    return "unknown";
+}
+
+// getaddrinfo cannot be interrupted, so it runs on a detached thread. If the
+// caller gives up first, the thread frees the result when it finally returns.
+ConnectStatus TcpConnector::Resolve(const std::string& host, int port, Clock::time_point deadline,
+                                    const std::function<bool()>& keepWaiting,
+                                    std::vector<ResolvedAddress>& out) {
+    EnsureWinsock();
+    Resolver resolver;
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        resolver = s_resolver;
+    }
+    if (resolver) {
+        out.clear();
+        return resolver(host, port, out) && !out.empty() ? ConnectStatus::Ok : ConnectStatus::Failed;
+    }
+
+    auto lookup = std::make_shared<Lookup>();
+    std::thread([lookup, host, service = std::to_string(port)]() {
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_protocol = IPPROTO_TCP;
+        addrinfo* result = nullptr;
+        int error = getaddrinfo(host.c_str(), service.c_str(), &hints, &result);
+
+        std::lock_guard<std::mutex> lock(lookup->mutex);
+        if (lookup->abandoned) {
+            if (result) freeaddrinfo(result);
+            return;
+        }
+        lookup->error = error;
+        lookup->result = result;
+        lookup->done = true;
+        lookup->cv.notify_all();
+    }).detach();
+
+    std::unique_lock<std::mutex> lock(lookup->mutex);
+    while (!lookup->done) {
+        ConnectStatus status = ConnectStatus::Ok;
+        if (Cancelled(keepWaiting)) status = ConnectStatus::Cancelled;
+        else if (Clock::now() >= deadline) status = ConnectStatus::TimedOut;
+        if (status != ConnectStatus::Ok) {
+            lookup->abandoned = true;
+            DEBUG_WARN_F("NETWORK", "DNS lookup for {} {}", host, DescribeConnectStatus(status));
+            return status;
+        }
+        lookup->cv.wait_for(lock, std::chrono::milliseconds(std::max(NextWaitMs(deadline), 1)));
+    }
+
+    if (lookup->error != 0 || !lookup->result) {
+        DEBUG_ERROR_F("NETWORK", "DNS lookup for {} failed: {}", host, gai_strerror(lookup->error));
+        return ConnectStatus::Failed;
+    }
+
+    out.clear();
+    for (addrinfo* ai = lookup->result; ai; ai = ai->ai_next) {
+        if (ai->ai_addrlen > sizeof(ResolvedAddress::addr)) continue;
+        ResolvedAddress address;
+        std::memcpy(address.addr.data(), ai->ai_addr, ai->ai_addrlen);
+        address.length = static_cast<int>(ai->ai_addrlen);
+        address.family = ai->ai_family;
+        out.push_back(address);
+    }
+    freeaddrinfo(lookup->result);
+    lookup->result = nullptr;
+    return out.empty() ? ConnectStatus::Failed : ConnectStatus::Ok;
+}
+
+ConnectStatus TcpConnector::Connect(const std::string& host, const std::vector<ResolvedAddress>& addresses,
+                                    Clock::time_point deadline, const std::function<bool()>& keepWaiting, int& fd) {
+    EnsureWinsock();
+    fd = -1;
+    auto ordered = OrderAddresses(host, addresses);
+    std::vector<Attempt> pending;
+    size_t next = 0;
+    auto nextStart = Clock::now();
+    ConnectStatus status = ConnectStatus::Failed;
+
+    auto finish = [&](const Attempt& winner) {
+        for (const auto& attempt : pending) {
+            if (attempt.fd != winner.fd) Close(attempt.fd);
+        }
+        fd = winner.fd;
+        std::lock_guard<std::mutex> lock(s_mutex);
+        s_preferredFamily[host] = winner.family;
+        return ConnectStatus::Ok;
+    };
+
+    while (true) {
+        if (Cancelled(keepWaiting)) { status = ConnectStatus::Cancelled; break; }
+        if (Clock::now() >= deadline) { status = ConnectStatus::TimedOut; break; }
+
+        if (next < ordered.size() && (pending.empty() || Clock::now() >= nextStart)) {
+            const auto& address = ordered[next++];
+            bool connected = false;
+            int candidate = StartAttempt(address, connected);
+            if (connected) return finish({candidate, address.family});
+            if (candidate >= 0) {
+                pending.push_back({candidate, address.family});
+                nextStart = Clock::now() + std::chrono::milliseconds(Config::CONNECT_ATTEMPT_DELAY_MS);
+            }
+            continue;
+        }
+        if (pending.empty()) break;
+
+        int waitMs = NextWaitMs(deadline);
+        if (next < ordered.size()) {
+            auto untilNext = std::chrono::duration_cast<std::chrono::milliseconds>(nextStart - Clock::now()).count();
+            waitMs = static_cast<int>(std::clamp<long long>(untilNext, 0, waitMs));
+        }
+        std::vector<int> fds;
+        for (const auto& attempt : pending) fds.push_back(attempt.fd);
+        std::vector<bool> ready;
+        if (WaitWritable(fds, waitMs, ready) < 0) break;
+
+        for (size_t i = pending.size(); i-- > 0;) {
+            if (!ready[i]) continue;
+            if (SocketError(pending[i].fd) == 0) return finish(pending[i]);
+            Close(pending[i].fd);
+            pending.erase(pending.begin() + static_cast<std::ptrdiff_t>(i));
+            nextStart = Clock::now();
+        }
+    }
+
+    for (const auto& attempt : pending) Close(attempt.fd);
+    if (status != ConnectStatus::Failed) {
+        DEBUG_WARN_F("NETWORK", "TCP connect to {} {}", host, DescribeConnectStatus(status));
+    }
+    return status;
+}
+
+void TcpConnector::Close(int fd) {
+    if (fd < 0) return;
+#ifdef _WIN32
+    closesocket(static_cast<SOCKET>(fd));
+#else
+    close(fd);
+#endif
+}
+
+std::vector<ResolvedAddress> TcpConnector::OrderAddresses(const std::string& host,
+                                                          const std::vector<ResolvedAddress>& addresses) {
+    if (addresses.empty()) return {};
+    int first = PreferredFamily(host);
+    if (first == 0) first = addresses.front().family;
+
+    std::vector<ResolvedAddress> preferred, other;
+    for (const auto& address : addresses) {
+        (address.family == first ? preferred : other).push_back(address);
+    }
+    std::vector<ResolvedAddress> ordered;
+    for (size_t i = 0; i < std::max(preferred.size(), other.size()); ++i) {
+        if (i < preferred.size()) ordered.push_back(preferred[i]);
+        if (i < other.size()) ordered.push_back(other[i]);
+    }
+    return ordered;
+}
+
+int TcpConnector::PreferredFamily(const std::string& host) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    auto it = s_preferredFamily.find(host);
+    return it == s_preferredFamily.end() ? 0 : it->second;
+}
+
+void TcpConnector::ForgetPreferredFamilies() {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_preferredFamily.clear();
+}
+
+void TcpConnector::SetResolver(Resolver resolver) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_resolver = std::move(resolver);
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "Config.h"
+#include <array>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Per-phase limits for one connection attempt. joinMs covers the relay's
+// channel_joined reply and is enforced by ConnectionManager.
+struct ConnectTimeouts {
+    int dnsMs = Config::DNS_TIMEOUT_MS;
+    int tcpMs = Config::TCP_CONNECT_TIMEOUT_MS;
+    int tlsMs = Config::TLS_HANDSHAKE_TIMEOUT_MS;
+    int joinMs = Config::HANDSHAKE_TIMEOUT_MS;
+};
+
+enum class ConnectStatus { Ok, Failed, TimedOut, Cancelled };
+
+const char* DescribeConnectStatus(ConnectStatus status);
+
+// A sockaddr copied out of getaddrinfo. Kept opaque so this header does not
+// pull winsock into every translation unit that includes it.
+struct ResolvedAddress {
+    std::array<unsigned char, 128> addr{};
+    int length = 0;
+    int family = 0;
+};
+
+// Resolve and connect with an explicit deadline. Both poll keepWaiting every
+// CONNECT_POLL_INTERVAL_MS, so another thread can abandon an attempt without
+// waiting for the OS timeout. A null keepWaiting never cancels.
+class TcpConnector {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Resolver = std::function<bool(const std::string& host, int port, std::vector<ResolvedAddress>& out)>;
+
+private:
+    static std::mutex s_mutex;
+    static std::unordered_map<std::string, int> s_preferredFamily;
+    static Resolver s_resolver;
+
+public:
+    static ConnectStatus Resolve(const std::string& host, int port, Clock::time_point deadline,
+                                 const std::function<bool()>& keepWaiting,
+                                 std::vector<ResolvedAddress>& out);
+    // Races the addresses RFC 8305 style: a new attempt starts every
+    // CONNECT_ATTEMPT_DELAY_MS (or as soon as one fails) while earlier ones
+    // stay in flight, and the first to complete wins. The winning family is
+    // remembered per host and tried first next time. On success fd is a
+    // connected non-blocking socket.
+    static ConnectStatus Connect(const std::string& host, const std::vector<ResolvedAddress>& addresses,
+                                 Clock::time_point deadline, const std::function<bool()>& keepWaiting, int& fd);
+    static void Close(int fd);
+
+    // Interleaves address families, starting with the host's remembered
+    // family or else the resolver's first choice.
+    static std::vector<ResolvedAddress> OrderAddresses(const std::string& host,
+                                                       const std::vector<ResolvedAddress>& addresses);
+    static int PreferredFamily(const std::string& host);
+    static void ForgetPreferredFamilies();
+
+    // Replaces getaddrinfo, for tests. Pass nullptr to restore it.
+    static void SetResolver(Resolver resolver);
+};
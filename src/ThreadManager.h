@@ -36,6 +36,10 @@ namespace ThreadManager {
             }
         }
         
+        void RequestStop() {
+            m_shouldStop = true;
+        }
+
         void Stop() {
             if (m_thread.joinable()) {
                 DEBUG_VERBOSE_F("THREAD", "Stopping worker thread: {}", m_name);
@@ -68,6 +72,10 @@ namespace ThreadManager {
         
         void StopAll() {
             DEBUG_VERBOSE_F("THREAD", "Stopping {} worker threads", m_threads.size());
+            // Signal every worker before joining any, so they wind down together.
+            for (auto& thread : m_threads) {
+                thread->RequestStop();
+            }
             for (auto& thread : m_threads) {
                 thread->Stop();
             }
@@ -0,0 +1,230 @@
+#include "TlsContext.h"
+#include "Debug.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <psa/crypto.h>
+#include <mbedtls/ssl_ciphersuites.h>
+#if defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#elif defined(_M_ARM64)
+#include <windows.h>
+#elif (defined(__aarch64__) || defined(__arm__)) && defined(__linux__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+// Set by cmake/MbedTlsUserConfig.h. Without it early_data profiles would
+// silently never send early data.
+#if !defined(MBEDTLS_SSL_EARLY_DATA)
+#error "Mbed TLS was built without cmake/MbedTlsUserConfig.h (MBEDTLS_SSL_EARLY_DATA is not defined)"
+#endif
+#if defined(NVDAREMOTE_TLS_LOW_MEMORY) && \
+    (!defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH) || !defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH))
+#error "NVDAREMOTE_TLS_LOW_MEMORY needs Mbed TLS built with cmake/MbedTlsLowMemory.h"
+#endif
+#if (defined(__aarch64__) || defined(_M_ARM64)) && !defined(MBEDTLS_SHA256_USE_ARMV8_A_CRYPTO_IF_PRESENT)
+#error "Mbed TLS was built without the Armv8 SHA-256 opt-in from cmake/MbedTlsUserConfig.h"
+#endif
+
+std::mutex TlsContext::s_mutex;
+std::mutex TlsContext::s_rngMutex;
+bool TlsContext::s_ready = false;
+bool TlsContext::s_tls13Ready = false;
+mbedtls_entropy_context TlsContext::s_entropy;
+mbedtls_ctr_drbg_context TlsContext::s_ctrDrbg;
+mbedtls_ssl_config TlsContext::s_config;
+mbedtls_ssl_config TlsContext::s_tls13Config;
+CipherPreference TlsContext::s_preference = CipherPreference::Auto;
+std::vector<int> TlsContext::s_ciphersuites;
+
+namespace {
+    const int AES_GCM_SUITES[] = {
+        MBEDTLS_TLS1_3_AES_128_GCM_SHA256,
+        MBEDTLS_TLS1_3_AES_256_GCM_SHA384,
+        MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256,
+        MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256,
+        MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_256_GCM_SHA384,
+        MBEDTLS_TLS_ECDHE_RSA_WITH_AES_256_GCM_SHA384,
+    };
+
+    const int CHACHA20_SUITES[] = {
+        MBEDTLS_TLS1_3_CHACHA20_POLY1305_SHA256,
+        MBEDTLS_TLS_ECDHE_ECDSA_WITH_CHACHA20_POLY1305_SHA256,
+        MBEDTLS_TLS_ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256,
+    };
+}
+
+bool ParseCipherPreference(const std::string& text, CipherPreference& out) {
+    if (text == "auto")          out = CipherPreference::Auto;
+    else if (text == "aes-gcm")  out = CipherPreference::AesGcm;
+    else if (text == "chacha20") out = CipherPreference::ChaCha20;
+    else if (text == "library")  out = CipherPreference::Library;
+    else return false;
+    return true;
+}
+
+const char* DescribeCipherPreference(CipherPreference preference) {
+    switch (preference) {
+        case CipherPreference::Auto:     return "auto";
+        case CipherPreference::AesGcm:   return "aes-gcm";
+        case CipherPreference::ChaCha20: return "chacha20";
+        case CipherPreference::Library:  return "library";
+    }
+    return "unknown";
+}
+
+void TlsContext::SetCipherPreference(CipherPreference preference) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (s_ready && preference != s_preference) {
+        DEBUG_WARN("SSL", "Cipher preference changes take effect after a restart");
+        return;
+    }
+    s_preference = preference;
+}
+
+bool TlsContext::HasAesAcceleration() {
+#if defined(_M_X64) || defined(_M_IX86)
+    int info[4] = {};
+    __cpuid(info, 1);
+    return (info[2] & (1 << 25)) != 0;
+#elif defined(__x86_64__) || defined(__i386__)
+    unsigned int eax, ebx, ecx, edx;
+    return __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_AES) != 0;
+#elif defined(_M_ARM64)
+    return IsProcessorFeaturePresent(PF_ARM_V8_CRYPTO_INSTRUCTIONS_AVAILABLE) != 0;
+#elif defined(__aarch64__) && defined(__linux__)
+    return (getauxval(AT_HWCAP) & HWCAP_AES) != 0;
+#elif defined(__arm__) && defined(__linux__)
+    return (getauxval(AT_HWCAP2) & HWCAP2_AES) != 0;
+#elif defined(__APPLE__) && defined(__aarch64__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+// The preferred AEAD's suites go first, then everything else the library
+// enables in its usual order, so servers without them still connect.
+std::vector<int> TlsContext::OrderCiphersuites(CipherPreference preference) {
+    std::vector<int> available;
+    for (const int* id = mbedtls_ssl_list_ciphersuites(); id && *id != 0; ++id) available.push_back(*id);
+
+    if (preference == CipherPreference::Auto) {
+        preference = HasAesAcceleration() ? CipherPreference::AesGcm : CipherPreference::ChaCha20;
+    }
+    std::vector<int> ordered;
+    auto prefer = [&](const int* begin, const int* end) {
+        for (const int* id = begin; id != end; ++id) {
+            if (std::find(available.begin(), available.end(), *id) != available.end()) ordered.push_back(*id);
+        }
+    };
+    if (preference == CipherPreference::AesGcm) prefer(std::begin(AES_GCM_SUITES), std::end(AES_GCM_SUITES));
+    if (preference == CipherPreference::ChaCha20) prefer(std::begin(CHACHA20_SUITES), std::end(CHACHA20_SUITES));
+    for (int id : available) {
+        if (std::find(ordered.begin(), ordered.end(), id) == ordered.end()) ordered.push_back(id);
+    }
+    ordered.push_back(0);
+    return ordered;
+}
+
+const mbedtls_ssl_config* TlsContext::Get(bool tls13) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (!s_ready) s_ready = Initialize();
+    if (!s_ready) return nullptr;
+    if (!tls13) return &s_config;
+    if (!s_tls13Ready) s_tls13Ready = InitializeTls13();
+    return s_tls13Ready ? &s_tls13Config : nullptr;
+}
+
+// Called with s_mutex held. The contexts are never freed: they live until
+// the process exits, and connections may still be closing while it does.
+bool TlsContext::Initialize() {
+    mbedtls_entropy_init(&s_entropy);
+    mbedtls_ctr_drbg_init(&s_ctrDrbg);
+    mbedtls_ssl_config_init(&s_config);
+
+    const char* pers = "ssl_client";
+    int ret = mbedtls_ctr_drbg_seed(&s_ctrDrbg, mbedtls_entropy_func, &s_entropy,
+                                    (const unsigned char*)pers, strlen(pers));
+    if (ret != 0) {
+        std::cerr << "Failed to seed RNG: " << ret << std::endl;
+    }
+    if (ret != 0 || !SetupConfig(s_config)) {
+        mbedtls_ssl_config_free(&s_config);
+        mbedtls_ctr_drbg_free(&s_ctrDrbg);
+        mbedtls_entropy_free(&s_entropy);
+        return false;
+    }
+
+    if (s_preference != CipherPreference::Library) {
+        s_ciphersuites = OrderCiphersuites(s_preference);
+        mbedtls_ssl_conf_ciphersuites(&s_config, s_ciphersuites.data());
+    }
+    mbedtls_ssl_conf_max_tls_version(&s_config, MBEDTLS_SSL_VERSION_TLS1_2);
+    DEBUG_INFO_F("SSL", "Cipher preference {}, AES acceleration {}",
+                 DescribeCipherPreference(s_preference), HasAesAcceleration() ? "available" : "unavailable");
+    DEBUG_VERBOSE("SSL", "Shared TLS configuration initialised");
+    return true;
+}
+
+// Called with s_mutex held, after Initialize, for the first early_data
+// connection.
+bool TlsContext::InitializeTls13() {
+    // TLS 1.3 runs its key schedule through PSA, which has to be set up
+    // before the first handshake.
+    psa_status_t psa = psa_crypto_init();
+    if (psa != PSA_SUCCESS) {
+        std::cerr << "Failed to initialise PSA crypto: " << psa << std::endl;
+        return false;
+    }
+
+    mbedtls_ssl_config_init(&s_tls13Config);
+    if (!SetupConfig(s_tls13Config)) {
+        mbedtls_ssl_config_free(&s_tls13Config);
+        return false;
+    }
+    if (s_preference != CipherPreference::Library) {
+        mbedtls_ssl_conf_ciphersuites(&s_tls13Config, s_ciphersuites.data());
+    }
+#if defined(MBEDTLS_SSL_SESSION_TICKETS) && defined(MBEDTLS_SSL_PROTO_TLS1_3)
+    // SSLClient saves TLS 1.3 tickets as they arrive.
+    mbedtls_ssl_conf_tls13_enable_signal_new_session_tickets(
+        &s_tls13Config, MBEDTLS_SSL_TLS1_3_SIGNAL_NEW_SESSION_TICKETS_ENABLED);
+#endif
+#if defined(MBEDTLS_SSL_EARLY_DATA)
+    // Only offered when a connection resumes a session whose ticket allows it.
+    mbedtls_ssl_conf_early_data(&s_tls13Config, MBEDTLS_SSL_EARLY_DATA_ENABLED);
+#endif
+    // Not capped in the low-memory build: early data needs TLS 1.3, so these
+    // connections keep full-size records unless the server picks TLS 1.2.
+    DEBUG_VERBOSE("SSL", "Shared TLS 1.3 configuration initialised");
+    return true;
+}
+
+// Settings both configs share.
+bool TlsContext::SetupConfig(mbedtls_ssl_config& config) {
+    int ret = mbedtls_ssl_config_defaults(&config,
+                                          MBEDTLS_SSL_IS_CLIENT,
+                                          MBEDTLS_SSL_TRANSPORT_STREAM,
+                                          MBEDTLS_SSL_PRESET_DEFAULT);
+    if (ret != 0) {
+        std::cerr << "Failed to set SSL config defaults: " << ret << std::endl;
+        return false;
+    }
+    mbedtls_ssl_conf_authmode(&config, MBEDTLS_SSL_VERIFY_NONE);
+    mbedtls_ssl_conf_rng(&config, Random, &s_ctrDrbg);
+#ifdef NVDAREMOTE_TLS_LOW_MEMORY
+    // Mbed TLS only negotiates max_fragment_length up to TLS 1.2. A server
+    // that ignores the extension still works, just with full-size buffers.
+    mbedtls_ssl_conf_max_frag_len(&config, MBEDTLS_SSL_MAX_FRAG_LEN_2048);
+#endif
+    return true;
+}
+
+int TlsContext::Random(void* context, unsigned char* output, size_t length) {
+    std::lock_guard<std::mutex> lock(s_rngMutex);
+    return mbedtls_ctr_drbg_random(context, output, length);
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <mutex>
+#include <string>
+#include <vector>
+#include <mbedtls/ssl.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/ctr_drbg.h>
+
+// Which AEAD to offer first. Auto picks AES-GCM when the CPU has AES
+// instructions (AES-NI, ARMv8 Crypto Extensions) and ChaCha20-Poly1305
+// otherwise; Library keeps Mbed TLS's own order.
+enum class CipherPreference { Auto, AesGcm, ChaCha20, Library };
+
+bool ParseCipherPreference(const std::string& text, CipherPreference& out);
+const char* DescribeCipherPreference(CipherPreference preference);
+
+// The client TLS configurations and random generator, shared by every
+// SSLClient in the process. Each config is built once and never modified
+// afterwards, which is what mbedtls requires of a config used by several
+// ssl contexts. Without MBEDTLS_THREADING_C the DRBG is not thread-safe,
+// so the configs' RNG callback serialises access to it.
+//
+// Connections stay on TLS 1.2 unless their profile sets early_data. Only
+// then is PSA crypto initialised and the TLS 1.3 config built, with
+// session tickets and early data enabled.
+class TlsContext {
+private:
+    static std::mutex s_mutex;
+    static std::mutex s_rngMutex;
+    static bool s_ready;
+    static bool s_tls13Ready;
+    static mbedtls_entropy_context s_entropy;
+    static mbedtls_ctr_drbg_context s_ctrDrbg;
+    static mbedtls_ssl_config s_config;
+    static mbedtls_ssl_config s_tls13Config;
+    static CipherPreference s_preference;
+    static std::vector<int> s_ciphersuites;
+
+    static bool Initialize();
+    static bool InitializeTls13();
+    static bool SetupConfig(mbedtls_ssl_config& config);
+    static int Random(void* context, unsigned char* output, size_t length);
+
+public:
+    // Builds the shared state on first use. Returns nullptr if seeding or
+    // config setup failed; the next call tries again.
+    static const mbedtls_ssl_config* Get(bool tls13 = false);
+
+    // Only takes effect before the first connection builds the config.
+    static void SetCipherPreference(CipherPreference preference);
+    static bool HasAesAcceleration();
+    // Ciphersuite ids in the order offered for the preference, ending in 0.
+    static std::vector<int> OrderCiphersuites(CipherPreference preference);
+};
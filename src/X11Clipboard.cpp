@@ -0,0 +1,382 @@
+#include "ClipboardBackend.h"
+#include "Debug.h"
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace {
+    constexpr long READ_CHUNK_LONGS = 64 * 1024 / 4;
+    constexpr size_t MAX_WRITE_CHUNK = 256 * 1024;
+    constexpr int CONVERT_TIMEOUT_MS = 2000;
+    constexpr int REQUEST_TIMEOUT_MS = 5000;
+
+    int IgnoreXError(Display*, XErrorEvent* e) {
+        DEBUG_VERBOSE_F("CLIP", "X error {} on request {}", static_cast<int>(e->error_code),
+                        static_cast<int>(e->request_code));
+        return 0;
+    }
+
+    class X11ClipboardBackend : public ClipboardBackend {
+    private:
+        struct Request {
+            bool set;
+            std::string text;
+            std::promise<bool> done;
+        };
+
+        struct IncrTransfer {
+            Window requestor;
+            Atom property;
+            Atom type;
+            std::shared_ptr<const std::string> data;
+            size_t offset;
+        };
+
+        Display* m_display = nullptr;
+        Window m_window = 0;
+        Atom m_clipboard = 0, m_utf8 = 0, m_text = 0, m_targets = 0, m_incr = 0, m_property = 0;
+        size_t m_writeChunk = 0;
+        int m_wakePipe[2] = {-1, -1};
+
+        std::thread m_thread;
+        std::mutex m_mutex;
+        std::deque<std::shared_ptr<Request>> m_requests;
+        bool m_stopping = false;
+
+        // Owner thread only.
+        std::shared_ptr<const std::string> m_owned;
+        std::vector<IncrTransfer> m_transfers;
+
+        void Run();
+        void Wake();
+        bool Submit(const std::shared_ptr<Request>& request);
+        void Process(Request& request);
+        void HandleEvent(const XEvent& ev);
+        void HandleSelectionRequest(const XSelectionRequestEvent& req);
+        void HandlePropertyDelete(const XPropertyEvent& ev);
+        template<typename Pred>
+        bool WaitForEvent(Pred pred, XEvent& out);
+        bool ReadProperty(std::string& out);
+        bool ReadSelection(std::string& out);
+
+    public:
+        bool Open();
+        ~X11ClipboardBackend() override;
+
+        const char* Name() const override { return "x11"; }
+        bool GetText(std::string& out) override;
+        bool SetText(const std::string& text) override;
+    };
+
+    bool X11ClipboardBackend::Open() {
+        m_display = XOpenDisplay(nullptr);
+        if (!m_display) return false;
+        XSetErrorHandler(IgnoreXError);
+
+        m_window = XCreateSimpleWindow(m_display, DefaultRootWindow(m_display), 0, 0, 1, 1, 0, 0, 0);
+        XSelectInput(m_display, m_window, PropertyChangeMask);
+
+        m_clipboard = XInternAtom(m_display, "CLIPBOARD", False);
+        m_utf8      = XInternAtom(m_display, "UTF8_STRING", False);
+        m_text      = XInternAtom(m_display, "TEXT", False);
+        m_targets   = XInternAtom(m_display, "TARGETS", False);
+        m_incr      = XInternAtom(m_display, "INCR", False);
+        m_property  = XInternAtom(m_display, "NVDAREMOTE_CLIPBOARD", False);
+
+        long maxRequest = XExtendedMaxRequestSize(m_display);
+        if (maxRequest == 0) maxRequest = XMaxRequestSize(m_display);
+        m_writeChunk = std::min(static_cast<size_t>(maxRequest) * 4 - 100, MAX_WRITE_CHUNK);
+
+        if (pipe(m_wakePipe) != 0) {
+            XCloseDisplay(m_display);
+            m_display = nullptr;
+            return false;
+        }
+        fcntl(m_wakePipe[0], F_SETFL, O_NONBLOCK);
+
+        m_thread = std::thread([this] { Run(); });
+        DEBUG_INFO("CLIP", "Using X11 clipboard backend");
+        return true;
+    }
+
+    X11ClipboardBackend::~X11ClipboardBackend() {
+        if (m_thread.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stopping = true;
+            }
+            Wake();
+            m_thread.join();
+        }
+        if (m_display) {
+            XDestroyWindow(m_display, m_window);
+            XCloseDisplay(m_display);
+        }
+        for (int fd : m_wakePipe) {
+            if (fd >= 0) close(fd);
+        }
+    }
+
+    void X11ClipboardBackend::Wake() {
+        char byte = 0;
+        [[maybe_unused]] auto n = write(m_wakePipe[1], &byte, 1);
+    }
+
+    bool X11ClipboardBackend::Submit(const std::shared_ptr<Request>& request) {
+        auto future = request->done.get_future();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_stopping) return false;
+            m_requests.push_back(request);
+        }
+        Wake();
+        if (future.wait_for(std::chrono::milliseconds(REQUEST_TIMEOUT_MS)) != std::future_status::ready) {
+            DEBUG_WARN("CLIP", "X11 clipboard request timed out");
+            return false;
+        }
+        return future.get();
+    }
+
+    bool X11ClipboardBackend::GetText(std::string& out) {
+        auto request = std::make_shared<Request>();
+        request->set = false;
+        if (!Submit(request)) return false;
+        out = std::move(request->text);
+        return true;
+    }
+
+    bool X11ClipboardBackend::SetText(const std::string& text) {
+        auto request = std::make_shared<Request>();
+        request->set = true;
+        request->text = text;
+        return Submit(request);
+    }
+
+    void X11ClipboardBackend::Run() {
+        const int xfd = ConnectionNumber(m_display);
+        while (true) {
+            std::deque<std::shared_ptr<Request>> requests;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_stopping) break;
+                requests.swap(m_requests);
+            }
+
+            for (auto& request : requests) Process(*request);
+
+            while (XPending(m_display)) {
+                XEvent ev;
+                XNextEvent(m_display, &ev);
+                HandleEvent(ev);
+            }
+
+            pollfd fds[2] = {{xfd, POLLIN, 0}, {m_wakePipe[0], POLLIN, 0}};
+            poll(fds, 2, -1);
+            if (fds[1].revents & POLLIN) {
+                char buf[64];
+                while (read(m_wakePipe[0], buf, sizeof(buf)) > 0) {}
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& request : m_requests) request->done.set_value(false);
+        m_requests.clear();
+    }
+
+    void X11ClipboardBackend::Process(Request& request) {
+        if (request.set) {
+            m_owned = std::make_shared<const std::string>(std::move(request.text));
+            XSetSelectionOwner(m_display, m_clipboard, m_window, CurrentTime);
+            bool owned = XGetSelectionOwner(m_display, m_clipboard) == m_window;
+            if (!owned) {
+                DEBUG_WARN("CLIP", "Failed to take ownership of the X11 clipboard");
+                m_owned.reset();
+            }
+            request.done.set_value(owned);
+            return;
+        }
+
+        if (m_owned && XGetSelectionOwner(m_display, m_clipboard) == m_window) {
+            request.text = *m_owned;
+            request.done.set_value(true);
+            return;
+        }
+        bool ok = ReadSelection(request.text);
+        request.done.set_value(ok);
+    }
+
+    template<typename Pred>
+    bool X11ClipboardBackend::WaitForEvent(Pred pred, XEvent& out) {
+        const int xfd = ConnectionNumber(m_display);
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(CONVERT_TIMEOUT_MS);
+        while (true) {
+            while (XPending(m_display)) {
+                XNextEvent(m_display, &out);
+                if (pred(out)) return true;
+                HandleEvent(out);
+            }
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+            if (remaining <= 0) return false;
+            pollfd fd = {xfd, POLLIN, 0};
+            poll(&fd, 1, static_cast<int>(remaining));
+        }
+    }
+
+    // Reads and deletes m_property in bounded chunks. Returns false once the
+    // property is empty, which ends an INCR transfer.
+    bool X11ClipboardBackend::ReadProperty(std::string& out) {
+        long offset = 0;
+        bool gotData = false;
+        while (true) {
+            Atom type;
+            int format;
+            unsigned long items, bytesAfter;
+            unsigned char* data = nullptr;
+            if (XGetWindowProperty(m_display, m_window, m_property, offset, READ_CHUNK_LONGS, False,
+                                   AnyPropertyType, &type, &format, &items, &bytesAfter, &data) != Success) {
+                break;
+            }
+            if (format == 8 && items > 0) {
+                if (offset == 0) out.reserve(out.size() + items + bytesAfter);
+                out.append(reinterpret_cast<const char*>(data), items);
+                gotData = true;
+            }
+            if (data) XFree(data);
+            if (bytesAfter == 0 || format != 8) break;
+            offset += static_cast<long>(items / 4);
+        }
+        XDeleteProperty(m_display, m_window, m_property);
+        return gotData;
+    }
+
+    bool X11ClipboardBackend::ReadSelection(std::string& out) {
+        if (XGetSelectionOwner(m_display, m_clipboard) == None) return true;
+
+        XDeleteProperty(m_display, m_window, m_property);
+        XConvertSelection(m_display, m_clipboard, m_utf8, m_property, m_window, CurrentTime);
+
+        XEvent ev;
+        if (!WaitForEvent([this](const XEvent& e) {
+                return e.type == SelectionNotify && e.xselection.selection == m_clipboard;
+            }, ev)) {
+            DEBUG_WARN("CLIP", "Timed out waiting for the X11 clipboard owner");
+            return false;
+        }
+        if (ev.xselection.property == None) return true;
+
+        Atom type;
+        int format;
+        unsigned long items, bytesAfter;
+        unsigned char* data = nullptr;
+        XGetWindowProperty(m_display, m_window, m_property, 0, 0, False, AnyPropertyType,
+                           &type, &format, &items, &bytesAfter, &data);
+        if (data) XFree(data);
+
+        if (type != m_incr) {
+            ReadProperty(out);
+            return true;
+        }
+
+        XDeleteProperty(m_display, m_window, m_property);
+        XFlush(m_display);
+        while (true) {
+            if (!WaitForEvent([this](const XEvent& e) {
+                    return e.type == PropertyNotify && e.xproperty.window == m_window &&
+                           e.xproperty.atom == m_property && e.xproperty.state == PropertyNewValue;
+                }, ev)) {
+                DEBUG_WARN("CLIP", "X11 clipboard transfer stalled");
+                return false;
+            }
+            if (!ReadProperty(out)) break;
+        }
+        return true;
+    }
+
+    void X11ClipboardBackend::HandleEvent(const XEvent& ev) {
+        switch (ev.type) {
+        case SelectionRequest:
+            HandleSelectionRequest(ev.xselectionrequest);
+            break;
+        case SelectionClear:
+            if (ev.xselectionclear.selection == m_clipboard) m_owned.reset();
+            break;
+        case PropertyNotify:
+            if (ev.xproperty.state == PropertyDelete) HandlePropertyDelete(ev.xproperty);
+            break;
+        default:
+            break;
+        }
+    }
+
+    void X11ClipboardBackend::HandleSelectionRequest(const XSelectionRequestEvent& req) {
+        XSelectionEvent reply = {};
+        reply.type = SelectionNotify;
+        reply.display = req.display;
+        reply.requestor = req.requestor;
+        reply.selection = req.selection;
+        reply.target = req.target;
+        reply.time = req.time;
+        reply.property = None;
+
+        Atom property = req.property == None ? req.target : req.property;
+        if (req.selection == m_clipboard && m_owned) {
+            if (req.target == m_targets) {
+                Atom targets[] = {m_targets, m_utf8, XA_STRING, m_text};
+                XChangeProperty(m_display, req.requestor, property, XA_ATOM, 32, PropModeReplace,
+                                reinterpret_cast<unsigned char*>(targets), 4);
+                reply.property = property;
+            } else if (req.target == m_utf8 || req.target == XA_STRING || req.target == m_text) {
+                Atom type = req.target == m_text ? m_utf8 : req.target;
+                if (m_owned->size() <= m_writeChunk) {
+                    XChangeProperty(m_display, req.requestor, property, type, 8, PropModeReplace,
+                                    reinterpret_cast<const unsigned char*>(m_owned->data()),
+                                    static_cast<int>(m_owned->size()));
+                } else {
+                    long size = static_cast<long>(m_owned->size());
+                    XSelectInput(m_display, req.requestor, PropertyChangeMask);
+                    XChangeProperty(m_display, req.requestor, property, m_incr, 32, PropModeReplace,
+                                    reinterpret_cast<unsigned char*>(&size), 1);
+                    m_transfers.push_back({req.requestor, property, type, m_owned, 0});
+                    DEBUG_VERBOSE_F("CLIP", "Starting INCR transfer of {} bytes", m_owned->size());
+                }
+                reply.property = property;
+            }
+        }
+
+        XSendEvent(m_display, req.requestor, False, NoEventMask, reinterpret_cast<XEvent*>(&reply));
+        XFlush(m_display);
+    }
+
+    void X11ClipboardBackend::HandlePropertyDelete(const XPropertyEvent& ev) {
+        auto it = std::find_if(m_transfers.begin(), m_transfers.end(), [&](const IncrTransfer& t) {
+            return t.requestor == ev.window && t.property == ev.atom;
+        });
+        if (it == m_transfers.end()) return;
+
+        size_t chunk = std::min(m_writeChunk, it->data->size() - it->offset);
+        XChangeProperty(m_display, it->requestor, it->property, it->type, 8, PropModeReplace,
+                        reinterpret_cast<const unsigned char*>(it->data->data() + it->offset),
+                        static_cast<int>(chunk));
+        it->offset += chunk;
+        if (chunk == 0) {
+            XSelectInput(m_display, it->requestor, NoEventMask);
+            m_transfers.erase(it);
+        }
+        XFlush(m_display);
+    }
+}
+
+std::unique_ptr<ClipboardBackend> CreateX11ClipboardBackend() {
+    auto backend = std::make_unique<X11ClipboardBackend>();
+    if (!backend->Open()) return nullptr;
+    return backend;
+}
@@ -6,12 +6,15 @@
 #include <unordered_map>
 #include <vector>
 #include <functional>
+#include "AppState.h"
 #include "CommandHandler.h"
 #include "ConfigFile.h"
 #include "Debug.h"
 #include "Audio.h"
+#include "SpeechQueue.h"
 #include "Speech.h"
 #include "Config.h"
+#include "TlsContext.h"
 
 #include "KeyboardState.h"
 #include "KeyboardHandler.h"
@@ -199,6 +202,8 @@ static void parseAddProfile(CommandLineArgs& args, int startIdx, int argc, char*
         {"--no-mute",         profileBoolOpt(&ProfileConfig::muteOnLocalControl, false)},
         {"--sounds",          profileBoolOpt(&ProfileConfig::forwardAudio,      true)},
         {"--no-sounds",       profileBoolOpt(&ProfileConfig::forwardAudio,      false)},
+        {"--broadcast",       profileBoolOpt(&ProfileConfig::broadcast,         true)},
+        {"--no-broadcast",    profileBoolOpt(&ProfileConfig::broadcast,         false)},
     };
     int i = startIdx;
     parseOpts(args, i, argc, argv, opts);
@@ -315,6 +320,8 @@ static void printHelpAddProfile(const char* prog) {
     std::cout << "      --no-mute             Don't mute when not active (default)\n";
     std::cout << "      --sounds              Forward NVDA sounds (default)\n";
     std::cout << "      --no-sounds           Disable sound forwarding\n";
+    std::cout << "      --broadcast           Include in the broadcast group\n";
+    std::cout << "      --no-broadcast        Exclude from the broadcast group (default)\n";
 }
 
 void printHelp(const char* prog, const std::string& topic = "") {
@@ -503,8 +510,15 @@ int main(int argc, char* argv[]) {
         DEBUG_INFO_F("MAIN", "Number of profiles: {}", cfg.profiles.size());
     }
 
+    CipherPreference ciphers = CipherPreference::Auto;
+    if (cfg.cipherPreference && !ParseCipherPreference(*cfg.cipherPreference, ciphers)) {
+        DEBUG_WARN_F("MAIN", "Unknown cipher_preference '{}', using auto", *cfg.cipherPreference);
+    }
+    TlsContext::SetCipherPreference(ciphers);
+
     if (cfg.audio.has_value() && !*cfg.audio) args.audioEnabled = false;
     Audio::SetEnabled(args.audioEnabled);
+    Audio::Initialize();
 
     Speech::SetEnabled(args.speechEnabled);
     if (args.speechEnabled) {
@@ -513,6 +527,7 @@ int main(int argc, char* argv[]) {
             Speech::SetEnabled(false);
         } else {
             DEBUG_INFO("MAIN", "Speech system initialized successfully");
+            SpeechQueue::Start();
         }
     } else {
         DEBUG_INFO("MAIN", "Speech system disabled by command line option");
@@ -536,21 +551,35 @@ int main(int argc, char* argv[]) {
     auto keyboard = std::make_unique<LinuxKeyboardGrab>();
 #endif
 
-    cmdHandler.SetDisconnectCallback([&keyboard]() {
-        DEBUG_INFO("MAIN", "Connection lost callback triggered");
-        keyboard->NotifyConnectionLost();
-    });
-
-    cmdHandler.SetReconnectCallback([&cmdHandler]() {
-        DEBUG_INFO("MAIN", "Auto-reconnect succeeded");
 #ifdef _WIN32
+    auto updateTrayTooltip = [&cmdHandler]() {
         std::string tooltip = std::string(Config::APP_NAME) + " - " +
                               std::to_string(cmdHandler.CountConnectedSessions()) + "/" +
                               std::to_string(cmdHandler.GetSessionCount()) + " connected";
         TrayIcon::SetTooltip(tooltip);
+    };
+#endif
+
+    // A dropped session reconnects on its own thread; the keyboard grab and
+    // the other sessions are left alone.
+    cmdHandler.SetDisconnectCallback([&]() {
+        DEBUG_INFO("MAIN", "Connection lost, profile will reconnect in the background");
+#ifdef _WIN32
+        updateTrayTooltip();
 #endif
     });
 
+    cmdHandler.SetReconnectCallback([&]() {
+        DEBUG_INFO("MAIN", "Auto-reconnect succeeded");
+#ifdef _WIN32
+        updateTrayTooltip();
+#endif
+    });
+
+    AppState::SetProfileSelectedCallback([&cmdHandler](int profileIndex, int nextProfileIndex) {
+        cmdHandler.WakeProfile(profileIndex, nextProfileIndex);
+    });
+
     keyboard->SetReconnectCallback([&cmdHandler]() {
         DEBUG_INFO("MAIN", "Reconnect all shortcut triggered");
         cmdHandler.ReconnectAll();
@@ -580,13 +609,6 @@ int main(int argc, char* argv[]) {
 #ifdef _WIN32
     bool isTrayMode = (GetConsoleWindow() == nullptr);
 
-    auto updateTrayTooltip = [&cmdHandler]() {
-        std::string tooltip = std::string(Config::APP_NAME) + " - " +
-                              std::to_string(cmdHandler.CountConnectedSessions()) + "/" +
-                              std::to_string(cmdHandler.GetSessionCount()) + " connected";
-        TrayIcon::SetTooltip(tooltip);
-    };
-
     if (isTrayMode) {
         if (!TrayIcon::Create()) {
             DEBUG_ERROR("MAIN", "Failed to create tray icon");
@@ -639,36 +661,31 @@ int main(int argc, char* argv[]) {
 
         if (g_shutdown) break;
 
-#ifdef _WIN32
-        if (isTrayMode)
-            TrayIcon::SetTooltip(std::string(Config::APP_NAME) + " - Reconnecting...");
-#endif
-
-        DEBUG_INFO("MAIN", "Checking connections...");
-        std::this_thread::sleep_for(std::chrono::seconds(2));
-
-        cmdHandler.ReconnectAll();
-
-        if (cmdHandler.CountConnectedSessions() == 0 && !g_shutdown) {
-            DEBUG_INFO("MAIN", "No connections active. Retrying in 5 seconds...");
-            std::this_thread::sleep_for(std::chrono::seconds(5));
-        }
-
-#ifdef _WIN32
-        if (isTrayMode) updateTrayTooltip();
-#endif
+        DEBUG_WARN("MAIN", "Keyboard message loop exited, reinstalling");
+        std::this_thread::sleep_for(std::chrono::seconds(1));
     }
 
     if (cmdThread.joinable()) cmdThread.join();
 
+    bool connectionsClosed = cmdHandler.Shutdown();
+
 #ifdef _WIN32
     if (isTrayMode) TrayIcon::Destroy();
 #endif
 
     DEBUG_VERBOSE("MAIN", "Cleaning up speech system");
+    SpeechQueue::Shutdown();
     Speech::Cleanup();
     DEBUG_VERBOSE("MAIN", "Speech system cleanup completed");
 
+    Audio::Cleanup();
+
+    if (!connectionsClosed) {
+        // Skip static destructors: connections still closing may be using them.
+        DEBUG_WARN("MAIN", "Exiting with connections still closing");
+        std::quick_exit(0);
+    }
+
     DEBUG_INFO("MAIN", "Application shutdown completed successfully");
     return 0;
 }
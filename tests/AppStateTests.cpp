@@ -0,0 +1,155 @@
+#include "TestFramework.h"
+#include "AppState.h"
+#include "KeyboardState.h"
+#include "RoutingState.h"
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+    void ResetRouting() {
+        RoutingState::Update([](RoutingSnapshot& s) { s = RoutingSnapshot{}; });
+        KeyboardState::ClearPressedKeys();
+    }
+}
+
+TEST_CASE("AppState: first connected profile becomes active") {
+    ResetRouting();
+    AppState::SetConnectedProfiles({1, 3}, {"work", "home"});
+    CHECK_EQ(AppState::GetActiveProfile(), 1);
+    CHECK(!AppState::IsSendingKeys());
+}
+
+TEST_CASE("AppState: forwarding toggles on and off") {
+    ResetRouting();
+    AppState::SetConnectedProfiles({0}, {"work"});
+    AppState::ToggleForwarding();
+    CHECK(AppState::IsSendingKeys());
+
+    KeyboardState::TrackKeyPress('A', 30, false);
+    AppState::ToggleForwarding();
+    CHECK(!AppState::IsSendingKeys());
+    CHECK(KeyboardState::GetAllPressedKeys().empty());
+}
+
+TEST_CASE("AppState: forwarding needs a connected profile") {
+    ResetRouting();
+    AppState::ToggleForwarding();
+    CHECK(!AppState::IsSendingKeys());
+    CHECK_EQ(AppState::GetActiveProfile(), -1);
+}
+
+TEST_CASE("AppState: cycling wraps and stops forwarding") {
+    ResetRouting();
+    AppState::SetConnectedProfiles({0, 2, 5}, {"a", "b", "c"});
+    AppState::ToggleForwarding();
+    AppState::CycleProfile();
+    CHECK_EQ(AppState::GetActiveProfile(), 2);
+    CHECK(!AppState::IsSendingKeys());
+    AppState::CycleProfile();
+    AppState::CycleProfile();
+    CHECK_EQ(AppState::GetActiveProfile(), 0);
+}
+
+TEST_CASE("AppState: losing the active profile falls back to the first") {
+    ResetRouting();
+    AppState::SetConnectedProfiles({0, 1}, {"a", "b"});
+    AppState::SetActiveProfile(1);
+    AppState::ToggleForwarding();
+    AppState::SetConnectedProfiles({0}, {"a"});
+    CHECK_EQ(AppState::GetActiveProfile(), 0);
+    CHECK(!AppState::IsSendingKeys());
+}
+
+TEST_CASE("AppState: broadcast needs a group") {
+    ResetRouting();
+    AppState::SetConnectedProfiles({0, 1}, {"a", "b"});
+    AppState::ToggleBroadcast();
+    CHECK(!AppState::IsBroadcasting());
+
+    AppState::SetBroadcastProfiles({0, 1});
+    AppState::ToggleBroadcast();
+    CHECK(AppState::IsBroadcasting());
+    CHECK(AppState::IsSendingKeys());
+
+    AppState::SetBroadcastProfiles({});
+    CHECK(!AppState::IsBroadcasting());
+    CHECK(!AppState::IsSendingKeys());
+}
+
+TEST_CASE("AppState: selecting a profile ends broadcast") {
+    ResetRouting();
+    AppState::SetConnectedProfiles({0, 1}, {"a", "b"});
+    AppState::SetBroadcastProfiles({0, 1});
+    AppState::ToggleBroadcast();
+    AppState::SetActiveProfile(1);
+    CHECK(!AppState::IsBroadcasting());
+    CHECK(!AppState::IsSendingKeys());
+    CHECK_EQ(AppState::GetActiveProfile(), 1);
+}
+
+TEST_CASE("AppState: losing the forwarding target returns keys to local") {
+    ResetRouting();
+    AppState::SetConnectedProfiles({0, 1, 2}, {"a", "b", "c"});
+    AppState::SetActiveProfile(1);
+    AppState::ToggleForwarding();
+    KeyboardState::TrackKeyPress('A', 30, false);
+
+    AppState::HandleProfileLost(2);
+    CHECK(AppState::IsSendingKeys());
+    CHECK_EQ(AppState::GetActiveProfile(), 1);
+
+    AppState::HandleProfileLost(1);
+    CHECK(!AppState::IsSendingKeys());
+    CHECK(KeyboardState::GetAllPressedKeys().empty());
+    CHECK_EQ(AppState::GetActiveProfile(), 1);
+}
+
+TEST_CASE("AppState: losing one broadcast profile keeps broadcasting") {
+    ResetRouting();
+    AppState::SetConnectedProfiles({0, 1}, {"a", "b"});
+    AppState::SetBroadcastProfiles({0, 1});
+    AppState::ToggleBroadcast();
+    AppState::HandleProfileLost(0);
+    CHECK(AppState::IsBroadcasting());
+    CHECK(AppState::IsSendingKeys());
+}
+
+TEST_CASE("AppState: selecting a profile reports the next one in cycle order") {
+    ResetRouting();
+    std::vector<std::pair<int, int>> selected;
+    AppState::SetProfileSelectedCallback([&selected](int profile, int next) { selected.emplace_back(profile, next); });
+    AppState::SetConnectedProfiles({0, 2, 5}, {"a", "b", "c"});
+
+    AppState::CycleProfile();
+    AppState::SetActiveProfile(5);
+    AppState::ToggleForwarding();
+    CHECK(AppState::IsReceivingKeys(5));
+    CHECK(!AppState::IsReceivingKeys(2));
+
+    CHECK_EQ(selected.size(), size_t(3));
+    CHECK(selected[0] == std::make_pair(2, 5));
+    CHECK(selected[1] == std::make_pair(5, 0));
+    CHECK(selected[2] == std::make_pair(5, 0));
+    AppState::SetProfileSelectedCallback(nullptr);
+}
+
+TEST_CASE("AppState: routing changes on another thread while keys are tracked") {
+    ResetRouting();
+    AppState::SetConnectedProfiles({0, 1}, {"a", "b"});
+    std::thread keyboard([] {
+        for (int i = 0; i < 2000; ++i) {
+            KeyboardState::UpdateModifierState(VK_LCONTROL, (i & 1) == 0);
+            KeyboardState::TrackKeyPress('A' + i % 26, 30, false);
+            KeyboardState::TrackKeyRelease('A' + i % 26);
+        }
+    });
+    for (int i = 0; i < 500; ++i) {
+        AppState::ToggleForwarding();
+        AppState::SetConnectedProfiles(i & 1 ? std::vector<int>{1} : std::vector<int>{0, 1}, {"a", "b"});
+        AppState::CycleProfile();
+    }
+    keyboard.join();
+    CHECK(KeyboardState::GetAllPressedKeys().empty());
+    KeyboardState::ResetModifiers();
+}
@@ -0,0 +1,196 @@
+#include "TestFramework.h"
+#include "AudioMixer.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// The mixer runs against a sink that keeps everything written to it, which
+// is not realtime, so each sound is mixed as fast as the thread can go.
+namespace {
+    class CaptureSink : public AudioSink {
+    private:
+        mutable std::mutex m_mutex;
+        std::condition_variable m_cv;
+        std::vector<int16_t> m_samples;
+        bool m_holding = false;
+        bool m_held = false;
+
+    public:
+        bool Write(const int16_t* samples, size_t frames) override {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_samples.insert(m_samples.end(), samples, samples + frames * AudioMixer::CHANNELS);
+            m_held = m_holding;
+            m_cv.notify_all();
+            m_cv.wait(lock, [this] { return !m_holding; });
+            m_held = false;
+            return true;
+        }
+        bool IsRealtime() const override { return false; }
+
+        // Makes the next Write wait, and so the mixer with it, until Release.
+        void Hold() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_holding = true;
+        }
+        bool WaitUntilHeld() {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            return m_cv.wait_for(lock, std::chrono::seconds(2), [this] { return m_held; });
+        }
+        void Release() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_holding = false;
+            m_cv.notify_all();
+        }
+
+        bool WaitForFrames(size_t frames) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            return m_cv.wait_for(lock, std::chrono::seconds(2),
+                                 [&] { return m_samples.size() >= frames * AudioMixer::CHANNELS; });
+        }
+        size_t Frames() const {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_samples.size() / AudioMixer::CHANNELS;
+        }
+        std::vector<int16_t> Samples() const {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_samples;
+        }
+    };
+
+    std::shared_ptr<const PcmBuffer> Constant(size_t frames, int16_t left, int16_t right) {
+        auto pcm = std::make_shared<PcmBuffer>();
+        for (size_t i = 0; i < frames; i++) {
+            pcm->samples.push_back(left);
+            pcm->samples.push_back(right);
+        }
+        return pcm;
+    }
+
+    // Rounds up to whole mixer blocks, which is what the sink receives.
+    size_t Blocks(size_t frames) {
+        return (frames + AudioMixer::BLOCK_FRAMES - 1) / AudioMixer::BLOCK_FRAMES * AudioMixer::BLOCK_FRAMES;
+    }
+
+    void Put16(std::ofstream& out, uint16_t v) { out.put(static_cast<char>(v & 0xff)).put(static_cast<char>(v >> 8)); }
+    void Put32(std::ofstream& out, uint32_t v) { Put16(out, static_cast<uint16_t>(v)); Put16(out, static_cast<uint16_t>(v >> 16)); }
+
+    // A mono 16-bit WAV whose samples count up from 0 in steps of 100.
+    fs::path WriteMonoWav(const std::string& name, uint32_t rate, uint32_t frames) {
+        fs::path path = fs::temp_directory_path() / name;
+        std::ofstream out(path, std::ios::binary);
+        out.write("RIFF", 4);
+        Put32(out, 36 + frames * 2);
+        out.write("WAVEfmt ", 8);
+        Put32(out, 16);
+        Put16(out, 1);
+        Put16(out, 1);
+        Put32(out, rate);
+        Put32(out, rate * 2);
+        Put16(out, 2);
+        Put16(out, 16);
+        out.write("data", 4);
+        Put32(out, frames * 2);
+        for (uint32_t i = 0; i < frames; i++) Put16(out, static_cast<uint16_t>(i * 100));
+        return path;
+    }
+}
+
+TEST_CASE("AudioMixer: a sound reaches the sink unchanged") {
+    auto pcm = std::make_shared<PcmBuffer>();
+    const size_t frames = AudioMixer::BLOCK_FRAMES * 2 + 7;
+    for (size_t i = 0; i < frames * AudioMixer::CHANNELS; i++) pcm->samples.push_back(static_cast<int16_t>(i % 1000));
+
+    auto sink = std::make_unique<CaptureSink>();
+    CaptureSink* capture = sink.get();
+    AudioMixer mixer(std::move(sink));
+    mixer.Play(pcm);
+    CHECK(capture->WaitForFrames(Blocks(frames)));
+    mixer.Stop();
+
+    auto samples = capture->Samples();
+    CHECK_EQ(samples.size(), Blocks(frames) * AudioMixer::CHANNELS);
+    for (size_t i = 0; i < pcm->samples.size(); i++) CHECK_EQ(samples[i], pcm->samples[i]);
+    for (size_t i = pcm->samples.size(); i < samples.size(); i++) CHECK_EQ(samples[i], 0);
+}
+
+TEST_CASE("AudioMixer: overlapping sounds are summed and clipped") {
+    auto sink = std::make_unique<CaptureSink>();
+    CaptureSink* capture = sink.get();
+    AudioMixer mixer(std::move(sink));
+
+    // Holding the first block keeps the mixer busy while the rest are
+    // queued, so they all start in the second block.
+    const size_t frames = AudioMixer::BLOCK_FRAMES;
+    capture->Hold();
+    mixer.Play(Constant(frames, 1, 1));
+    CHECK(capture->WaitUntilHeld());
+    mixer.Play(Constant(frames, 20000, -20000));
+    mixer.Play(Constant(frames, 20000, -20000));
+    mixer.Play(Constant(frames, -3000, 3000));
+    capture->Release();
+    CHECK(capture->WaitForFrames(frames * 2));
+    mixer.Stop();
+
+    auto samples = capture->Samples();
+    CHECK_EQ(samples.size(), frames * 2 * AudioMixer::CHANNELS);
+    for (size_t i = frames * AudioMixer::CHANNELS; i < samples.size(); i += 2) {
+        CHECK_EQ(samples[i], INT16_MAX);
+        CHECK_EQ(samples[i + 1], INT16_MIN);
+    }
+}
+
+TEST_CASE("AudioMixer: the sink is silent until something plays") {
+    auto sink = std::make_unique<CaptureSink>();
+    CaptureSink* capture = sink.get();
+    AudioMixer mixer(std::move(sink));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK_EQ(capture->Frames(), 0u);
+
+    mixer.Play(nullptr);
+    mixer.Play(std::make_shared<PcmBuffer>());
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK_EQ(capture->Frames(), 0u);
+}
+
+TEST_CASE("AudioMixer: mono WAV files decode to stereo at the mixer rate") {
+    fs::path path = WriteMonoWav("nvdaremote_mixer_mono.wav", AudioMixer::SAMPLE_RATE, 300);
+    auto pcm = DecodeWavFile(path.string());
+    CHECK(pcm != nullptr);
+    CHECK_EQ(pcm->Frames(), 300u);
+    for (size_t i = 0; i < pcm->Frames(); i++) {
+        CHECK_EQ(pcm->samples[i * 2], static_cast<int16_t>(i * 100));
+        CHECK_EQ(pcm->samples[i * 2 + 1], static_cast<int16_t>(i * 100));
+    }
+
+    // Half the rate doubles the length, with interpolated samples between.
+    fs::path half = WriteMonoWav("nvdaremote_mixer_half.wav", AudioMixer::SAMPLE_RATE / 2, 300);
+    auto resampled = DecodeWavFile(half.string());
+    CHECK(resampled != nullptr);
+    CHECK_EQ(resampled->Frames(), 600u);
+    CHECK_EQ(resampled->samples[2], 50);
+    CHECK_EQ(resampled->samples[4], 100);
+
+    fs::remove(path);
+    fs::remove(half);
+}
+
+TEST_CASE("AudioMixer: files that are not PCM WAV are rejected") {
+    fs::path path = fs::temp_directory_path() / "nvdaremote_mixer_bad.wav";
+    {
+        const char header[] = "RIFF\x1c\0\0\0WAVEdata\x10\0\0\0not a fmt chunk!";
+        std::ofstream out(path, std::ios::binary);
+        out.write(header, sizeof(header) - 1);
+    }
+    CHECK(DecodeWavFile(path.string()) == nullptr);
+    CHECK(DecodeWavFile((fs::temp_directory_path() / "nvdaremote_mixer_missing.wav").string()) == nullptr);
+    fs::remove(path);
+}
@@ -0,0 +1,151 @@
+#include "TestFramework.h"
+#include "ConfigFile.h"
+#include <nlohmann/json.hpp>
+#include <filesystem>
+#include <fstream>
+#include <chrono>
+
+namespace fs = std::filesystem;
+
+namespace {
+    // A scratch config path that is removed again when the test ends.
+    struct TempConfig {
+        fs::path path;
+
+        TempConfig() {
+            static int counter = 0;
+            path = fs::temp_directory_path() /
+                   ("nvdaremote_test_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) +
+                    "_" + std::to_string(counter++) + ".json");
+        }
+        ~TempConfig() {
+            std::error_code ec;
+            fs::remove(path, ec);
+        }
+
+        void Write(const std::string& text) const {
+            std::ofstream(path) << text;
+        }
+        nlohmann::json Read() const {
+            std::ifstream in(path);
+            return nlohmann::json::parse(in);
+        }
+    };
+}
+
+TEST_CASE("ConfigFile: save and load round trip") {
+    ConfigFileData data;
+    data.debugLevel = "verbose";
+    data.audio = false;
+    data.cycleShortcut = "ctrl+alt+f10";
+    data.broadcastShortcut = "ctrl+alt+b";
+    data.cipherPreference = "chacha20";
+
+    ProfileConfig p;
+    p.name = "work";
+    p.host = "relay.example";
+    p.port = 7000;
+    p.key = "secret";
+    p.speech = false;
+    p.broadcast = true;
+    p.sendQueueLimit = 64;
+    p.clipboardWhenFull = "block";
+    p.earlyData = true;
+    p.onDemand = true;
+    p.idleTimeoutMs = 60000;
+    data.profiles.push_back(p);
+
+    TempConfig file;
+    CHECK(ConfigFile::Save(file.path.string(), data));
+    ConfigFileData loaded = ConfigFile::Load(file.path.string());
+
+    CHECK_EQ(loaded.debugLevel.value_or(""), std::string("verbose"));
+    CHECK(loaded.audio.has_value() && !*loaded.audio);
+    CHECK_EQ(loaded.cycleShortcut.value_or(""), std::string("ctrl+alt+f10"));
+    CHECK_EQ(loaded.broadcastShortcut.value_or(""), std::string("ctrl+alt+b"));
+    CHECK_EQ(loaded.cipherPreference.value_or(""), std::string("chacha20"));
+    CHECK(!loaded.exitShortcut.has_value());
+    CHECK_EQ(loaded.profiles.size(), 1u);
+
+    const auto& q = loaded.profiles[0];
+    CHECK_EQ(q.name, p.name);
+    CHECK_EQ(q.host, p.host);
+    CHECK_EQ(q.port, p.port);
+    CHECK_EQ(q.key, p.key);
+    CHECK_EQ(q.speech, p.speech);
+    CHECK_EQ(q.broadcast, p.broadcast);
+    CHECK_EQ(q.sendQueueLimit, p.sendQueueLimit);
+    CHECK_EQ(q.clipboardWhenFull, p.clipboardWhenFull);
+    CHECK_EQ(q.earlyData, p.earlyData);
+    CHECK_EQ(q.onDemand, p.onDemand);
+    CHECK_EQ(q.idleTimeoutMs, p.idleTimeoutMs);
+}
+
+TEST_CASE("ConfigFile: created default loads with the default shortcuts") {
+    TempConfig file;
+    CHECK(ConfigFile::CreateDefault(file.path.string()));
+    ConfigFileData loaded = ConfigFile::Load(file.path.string());
+    CHECK(loaded.profiles.empty());
+    CHECK_EQ(file.Read().value("schema_version", 0), 1);
+}
+
+TEST_CASE("ConfigFile: migrates flat shortcuts into the shortcuts object") {
+    TempConfig file;
+    file.Write(R"({"cycle_shortcut":"ctrl+f9","exit_shortcut":"ctrl+f8","host":"h","key":"k"})");
+
+    CHECK(ConfigFile::Migrate(file.path.string()));
+    auto j = file.Read();
+    CHECK_EQ(j.value("schema_version", 0), 1);
+    CHECK(!j.contains("cycle_shortcut"));
+    CHECK_EQ(j["shortcuts"].value("cycle", ""), std::string("ctrl+f9"));
+
+    ConfigFileData loaded = ConfigFile::Load(file.path.string());
+    CHECK_EQ(loaded.exitShortcut.value_or(""), std::string("ctrl+f8"));
+    CHECK_EQ(loaded.host.value_or(""), std::string("h"));
+
+    CHECK(!ConfigFile::Migrate(file.path.string()));
+}
+
+TEST_CASE("ConfigFile: migrate leaves unparseable and non-object files alone") {
+    TempConfig file;
+    file.Write("not json");
+    CHECK(!ConfigFile::Migrate(file.path.string()));
+    file.Write("[1, 2]");
+    CHECK(!ConfigFile::Migrate(file.path.string()));
+    CHECK(!ConfigFile::Migrate((file.path.string() + ".missing")));
+}
+
+TEST_CASE("ConfigFile: a non-integer schema version is treated as unversioned") {
+    TempConfig file;
+    file.Write(R"({"schema_version":"1","reconnect_shortcut":"ctrl+f7"})");
+    CHECK(ConfigFile::Migrate(file.path.string()));
+    auto j = file.Read();
+    CHECK_EQ(j.value("schema_version", 0), 1);
+    CHECK_EQ(j["shortcuts"].value("reconnect", ""), std::string("ctrl+f7"));
+}
+
+TEST_CASE("ConfigFile: incomplete profiles are skipped and names default to host") {
+    ConfigFileData data = ConfigFile::LoadFromString(R"({"profiles":[
+        {"host":"a.example","key":"k1"},
+        {"name":"no key","host":"b.example"},
+        42
+    ]})");
+    CHECK_EQ(data.profiles.size(), 1u);
+    CHECK_EQ(data.profiles[0].name, std::string("a.example"));
+    CHECK_EQ(data.profiles[0].port, 6837);
+}
+
+TEST_CASE("ConfigFile: wrongly typed fields keep their defaults") {
+    ConfigFileData data = ConfigFile::LoadFromString(
+        R"({"audio":"yes","profiles":[{"host":"h","key":"k","port":"7000","speech":1}]})");
+    CHECK(!data.audio.has_value());
+    CHECK_EQ(data.profiles.size(), 1u);
+    CHECK_EQ(data.profiles[0].port, 6837);
+    CHECK(data.profiles[0].speech);
+}
+
+TEST_CASE("ConfigFile: malformed JSON loads as empty") {
+    ConfigFileData data = ConfigFile::LoadFromString("{\"profiles\": [");
+    CHECK(data.profiles.empty());
+    CHECK(!data.debugLevel.has_value());
+}
@@ -0,0 +1,257 @@
+#include "TestFramework.h"
+#include "ConnectionManager.h"
+#include "SSLClient.h"
+#include "TcpConnector.h"
+#include "TlsContext.h"
+#include <mbedtls/ssl_ciphersuites.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // Completes TCP handshakes through the kernel backlog but never reads or
+    // writes, like a relay that has stopped responding.
+    class SilentListener {
+    private:
+        int m_fd = -1;
+        int m_port = 0;
+
+    public:
+        explicit SilentListener(int backlog = 16) {
+#ifdef _WIN32
+            WSADATA data;
+            WSAStartup(MAKEWORD(2, 2), &data);
+#endif
+            auto s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            socklen_t length = sizeof(addr);
+            if (bind(s, reinterpret_cast<sockaddr*>(&addr), length) != 0 || listen(s, backlog) != 0 ||
+                getsockname(s, reinterpret_cast<sockaddr*>(&addr), &length) != 0) {
+                TcpConnector::Close(static_cast<int>(s));
+                return;
+            }
+            m_fd = static_cast<int>(s);
+            m_port = ntohs(addr.sin_port);
+        }
+        ~SilentListener() { TcpConnector::Close(m_fd); }
+        int Port() const { return m_port; }
+    };
+
+    // A listener whose accept queue is already full, so further SYNs go
+    // unanswered and connects to it stall like an unreachable address.
+    class BlackholeListener {
+    private:
+        SilentListener m_listener{0};
+        std::vector<int> m_fillers;
+
+    public:
+        BlackholeListener() {
+            std::vector<ResolvedAddress> addresses;
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+            TcpConnector::Resolve("127.0.0.1", Port(), deadline, nullptr, addresses);
+            for (int i = 0; i < 4; ++i) {
+                int fd = -1;
+                if (TcpConnector::Connect("", addresses, std::chrono::steady_clock::now() + std::chrono::milliseconds(50),
+                                          nullptr, fd) == ConnectStatus::Ok) {
+                    m_fillers.push_back(fd);
+                }
+            }
+        }
+        ~BlackholeListener() {
+            for (int fd : m_fillers) TcpConnector::Close(fd);
+        }
+        int Port() const { return m_listener.Port(); }
+    };
+
+    ResolvedAddress LoopbackAddress(int family, int port) {
+        ResolvedAddress address;
+        address.family = family;
+        if (family == AF_INET6) {
+            sockaddr_in6 addr{};
+            addr.sin6_family = AF_INET6;
+            addr.sin6_addr = in6addr_loopback;
+            addr.sin6_port = htons(static_cast<unsigned short>(port));
+            std::memcpy(address.addr.data(), &addr, sizeof(addr));
+            address.length = sizeof(addr);
+        } else {
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            addr.sin_port = htons(static_cast<unsigned short>(port));
+            std::memcpy(address.addr.data(), &addr, sizeof(addr));
+            address.length = sizeof(addr);
+        }
+        return address;
+    }
+
+    int PeerPort(int fd) {
+        sockaddr_in addr{};
+        socklen_t length = sizeof(addr);
+        if (getpeername(fd, reinterpret_cast<sockaddr*>(&addr), &length) != 0) return -1;
+        return ntohs(addr.sin_port);
+    }
+
+    long long MillisecondsSince(Clock::time_point start) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count();
+    }
+}
+
+TEST_CASE("Connect: resolves and connects to a local listener") {
+    SilentListener listener;
+    CHECK(listener.Port() > 0);
+
+    std::vector<ResolvedAddress> addresses;
+    auto deadline = Clock::now() + std::chrono::seconds(2);
+    CHECK(TcpConnector::Resolve("127.0.0.1", listener.Port(), deadline, nullptr, addresses) == ConnectStatus::Ok);
+    CHECK(!addresses.empty());
+
+    int fd = -1;
+    CHECK(TcpConnector::Connect("127.0.0.1", addresses, deadline, nullptr, fd) == ConnectStatus::Ok);
+    CHECK(fd >= 0);
+    TcpConnector::Close(fd);
+}
+
+TEST_CASE("Connect: all clients share one TLS configuration") {
+    const mbedtls_ssl_config* first = TlsContext::Get();
+    CHECK(first != nullptr);
+    CHECK(TlsContext::Get() == first);
+
+    const mbedtls_ssl_config* tls13 = TlsContext::Get(true);
+    CHECK(tls13 != nullptr);
+    CHECK(tls13 != first);
+    CHECK(TlsContext::Get(true) == tls13);
+}
+
+TEST_CASE("Connect: the preferred AEAD is offered first") {
+    auto library = TlsContext::OrderCiphersuites(CipherPreference::Library);
+    CHECK(library.size() > 1);
+    CHECK_EQ(library.back(), 0);
+
+    auto chacha = TlsContext::OrderCiphersuites(CipherPreference::ChaCha20);
+    CHECK_EQ(chacha.size(), library.size());
+    CHECK(chacha.front() == MBEDTLS_TLS1_3_CHACHA20_POLY1305_SHA256 ||
+          chacha.front() == MBEDTLS_TLS_ECDHE_ECDSA_WITH_CHACHA20_POLY1305_SHA256 ||
+          chacha.front() == MBEDTLS_TLS_ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256);
+
+    auto aes = TlsContext::OrderCiphersuites(CipherPreference::AesGcm);
+    CHECK_EQ(aes.size(), library.size());
+    CHECK(aes.front() == MBEDTLS_TLS1_3_AES_128_GCM_SHA256 ||
+          aes.front() == MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256);
+
+    CipherPreference parsed;
+    CHECK(ParseCipherPreference("aes-gcm", parsed) && parsed == CipherPreference::AesGcm);
+    CHECK(!ParseCipherPreference("rc4", parsed));
+}
+
+TEST_CASE("Connect: TLS handshake to a silent listener times out") {
+    SilentListener listener;
+    SSLClient client;
+    ConnectTimeouts timeouts;
+    timeouts.tlsMs = 300;
+
+    auto start = Clock::now();
+    CHECK(!client.Connect("127.0.0.1", listener.Port(), timeouts));
+    auto elapsed = MillisecondsSince(start);
+    CHECK(elapsed >= 250);
+    CHECK(elapsed < 2000);
+    CHECK(!client.IsConnected());
+}
+
+TEST_CASE("Connect: cancelling abandons a stalled handshake") {
+    SilentListener listener;
+    SSLClient client;
+    ConnectTimeouts timeouts;
+    timeouts.tlsMs = 10000;
+    std::atomic<bool> keepWaiting{true};
+
+    std::thread canceller([&keepWaiting]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        keepWaiting = false;
+    });
+    auto start = Clock::now();
+    CHECK(!client.Connect("127.0.0.1", listener.Port(), timeouts, [&keepWaiting] { return keepWaiting.load(); }));
+    CHECK(MillisecondsSince(start) < 1000);
+    canceller.join();
+}
+
+TEST_CASE("Connect: DNS lookups give up at the deadline") {
+    std::vector<ResolvedAddress> addresses;
+    auto start = Clock::now();
+    auto status = TcpConnector::Resolve("unresolvable.invalid", 6837, start + std::chrono::milliseconds(300),
+                                        nullptr, addresses);
+    CHECK(status != ConnectStatus::Ok);
+    CHECK(MillisecondsSince(start) < 1500);
+}
+
+TEST_CASE("Connect: shutdown interrupts a connection attempt") {
+    SilentListener listener;
+    ConnectionManager manager;
+    std::thread attempt([&manager, &listener]() {
+        manager.EstablishConnection("127.0.0.1", listener.Port(), "test-channel");
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    auto start = Clock::now();
+    manager.RequestShutdown();
+    attempt.join();
+    CHECK(MillisecondsSince(start) < 1000);
+    CHECK(!manager.IsConnected());
+}
+
+TEST_CASE("Connect: a stalled address does not hold up the live one") {
+    BlackholeListener dead;
+    SilentListener live;
+    TcpConnector::SetResolver([&](const std::string&, int, std::vector<ResolvedAddress>& out) {
+        out = {LoopbackAddress(AF_INET, dead.Port()), LoopbackAddress(AF_INET, live.Port())};
+        return true;
+    });
+
+    std::vector<ResolvedAddress> addresses;
+    auto start = Clock::now();
+    auto deadline = start + std::chrono::seconds(3);
+    CHECK(TcpConnector::Resolve("racing.test", 6837, deadline, nullptr, addresses) == ConnectStatus::Ok);
+    int fd = -1;
+    CHECK(TcpConnector::Connect("racing.test", addresses, deadline, nullptr, fd) == ConnectStatus::Ok);
+    CHECK(MillisecondsSince(start) < 1000);
+    CHECK(PeerPort(fd) == live.Port());
+    TcpConnector::Close(fd);
+    TcpConnector::SetResolver(nullptr);
+}
+
+TEST_CASE("Connect: the winning address family is tried first next time") {
+    TcpConnector::ForgetPreferredFamilies();
+    SilentListener live;
+    SilentListener unused;
+    int deadPort = unused.Port();
+    TcpConnector::SetResolver([&](const std::string&, int, std::vector<ResolvedAddress>& out) {
+        out = {LoopbackAddress(AF_INET6, deadPort), LoopbackAddress(AF_INET, live.Port())};
+        return true;
+    });
+
+    std::vector<ResolvedAddress> addresses;
+    auto deadline = Clock::now() + std::chrono::seconds(3);
+    CHECK(TcpConnector::Resolve("dualstack.test", 6837, deadline, nullptr, addresses) == ConnectStatus::Ok);
+    CHECK(TcpConnector::OrderAddresses("dualstack.test", addresses).front().family == AF_INET6);
+
+    int fd = -1;
+    CHECK(TcpConnector::Connect("dualstack.test", addresses, deadline, nullptr, fd) == ConnectStatus::Ok);
+    TcpConnector::Close(fd);
+    CHECK(TcpConnector::PreferredFamily("dualstack.test") == AF_INET);
+    CHECK(TcpConnector::OrderAddresses("dualstack.test", addresses).front().family == AF_INET);
+    CHECK(TcpConnector::PreferredFamily("other.test") == 0);
+    TcpConnector::SetResolver(nullptr);
+    TcpConnector::ForgetPreferredFamilies();
+}
@@ -0,0 +1,361 @@
+#include "TestFramework.h"
+#include "ConnectionManager.h"
+#include "AppState.h"
+#include "Clipboard.h"
+#include "ClipboardBackend.h"
+#include "CommandHandler.h"
+#include "MessageSender.h"
+#include "RoutingState.h"
+#include "SpeechQueue.h"
+#include "TestRelay.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Relay lines are fed straight into the dispatcher. Speech and audio are not
+// initialised, so handlers only reach the speech queue and the clipboard.
+namespace {
+    uint64_t Utterances() {
+        auto stats = SpeechQueue::GetStats();
+        return stats.spoken + stats.merged + stats.depth;
+    }
+
+    bool WaitForUtterances(uint64_t expected) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (Utterances() < expected) {
+            if (std::chrono::steady_clock::now() > deadline) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    void ResetRouting() {
+        RoutingState::Update([](RoutingSnapshot& s) { s = RoutingSnapshot{}; });
+    }
+
+    ProfileConfig OnDemandProfile(const std::string& name, int port, int idleTimeoutMs) {
+        ProfileConfig p;
+        p.name = name;
+        p.host = "127.0.0.1";
+        p.port = port;
+        p.key = name;
+        p.onDemand = true;
+        p.idleTimeoutMs = idleTimeoutMs;
+        return p;
+    }
+
+    // Sessions connecting through a relay that holds their handshake far
+    // longer than the TLS timeout, so each is parked mid-connect.
+    std::vector<std::unique_ptr<ConnectionManager>> StalledSessions(TestRelay& relay, int count) {
+        auto p = OnDemandProfile("stalled", relay.Port(), 0);
+        p.tlsTimeoutMs = 60000;
+        int accepted = relay.AcceptedConnections();
+        std::vector<std::unique_ptr<ConnectionManager>> managers;
+        for (int i = 0; i < count; i++) {
+            auto manager = std::make_unique<ConnectionManager>();
+            manager->ApplyProfileConfig(p);
+            if (!manager->PrepareConnection(p.host, p.port, p.key)) continue;
+            manager->Wake(false);
+            managers.push_back(std::move(manager));
+        }
+        WaitFor([&] { return relay.AcceptedConnections() == accepted + count; });
+        return managers;
+    }
+}
+
+TEST_CASE("ConnectionManager: speak messages reach the speech queue") {
+    SpeechQueue::Start();
+    ConnectionManager manager;
+    manager.SetSpeechEnabled(true);
+
+    uint64_t before = Utterances();
+    manager.HandleIncomingMessage(R"({"type":"speak","sequence":["Desktop",{"type":"pitch"},"list"],"origin":2})");
+    CHECK(WaitForUtterances(before + 1));
+
+    manager.SetSpeechEnabled(false);
+    before = Utterances();
+    manager.HandleIncomingMessage(R"({"type":"speak","sequence":["muted"]})");
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK_EQ(Utterances(), before);
+    SpeechQueue::Shutdown();
+}
+
+TEST_CASE("ConnectionManager: speech sequences join their strings with single spaces") {
+    auto sequence = json::parse(R"(["Desktop", {"type":"pitch"}, "", "list", 3, "  2 items"])");
+    CHECK_EQ(ConnectionManager::JoinSpeechSequence(sequence), "Desktop list   2 items");
+    CHECK(ConnectionManager::JoinSpeechSequence(json::array()).empty());
+    CHECK(ConnectionManager::JoinSpeechSequence(json::parse(R"(["", {"type":"pitch"}])")).empty());
+}
+
+TEST_CASE("ConnectionManager: speech joining reuses one buffer") {
+    json sequence = json::array();
+    for (int i = 0; i < 500; i++) sequence.push_back("line " + std::to_string(i) + " of the document");
+    std::string_view first = ConnectionManager::JoinSpeechSequence(sequence);
+    CHECK(first.size() > 10000);
+    CHECK(first.substr(0, 24) == "line 0 of the document l");
+
+    // A shorter sequence fits in the capacity the first one left behind.
+    std::string_view second = ConnectionManager::JoinSpeechSequence(json::parse(R"(["short"])"));
+    CHECK_EQ(second, "short");
+    CHECK(second.data() == first.data());
+}
+
+TEST_CASE("ConnectionManager: malformed messages are ignored") {
+    SpeechQueue::Start();
+    ConnectionManager manager;
+    manager.SetSpeechEnabled(true);
+    uint64_t before = Utterances();
+
+    manager.HandleIncomingMessage("not json");
+    manager.HandleIncomingMessage("[1,2,3]");
+    manager.HandleIncomingMessage("null");
+    manager.HandleIncomingMessage(R"({"type":7})");
+    manager.HandleIncomingMessage(R"({"type":"no_such_type"})");
+    manager.HandleIncomingMessage(R"({"type":"speak","sequence":"not an array"})");
+    manager.HandleIncomingMessage(R"({"type":"tone","hz":"440","length":null})");
+    manager.HandleIncomingMessage(R"({"type":"set_clipboard_text","text":12})");
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK_EQ(Utterances(), before);
+    SpeechQueue::Shutdown();
+}
+
+TEST_CASE("ConnectionManager: losing one session leaves the others running") {
+    SpeechQueue::Start();
+    constexpr int SESSIONS = 3;
+    TestRelay relays[SESSIONS];
+    ConnectionManager managers[SESSIONS];
+    std::atomic<int> lost[SESSIONS] = {};
+    for (int i = 0; i < SESSIONS; i++) {
+        managers[i].SetSpeechEnabled(true);
+        managers[i].SetProfileIndex(i);
+        managers[i].SetDisconnectCallback([&lost, i]() { lost[i]++; });
+        CHECK(managers[i].EstablishConnection("127.0.0.1", relays[i].Port(), "test-channel"));
+    }
+    AppState::SetConnectedProfiles({0, 1, 2}, {"a", "b", "c"});
+    AppState::SetActiveProfile(0);
+    AppState::ToggleForwarding();
+
+    relays[1].DropAll();
+    CHECK(WaitFor([&] { return lost[1] == 1; }));
+    CHECK_EQ(lost[0].load(), 0);
+    CHECK_EQ(lost[2].load(), 0);
+    CHECK(managers[0].IsConnected());
+    CHECK(managers[2].IsConnected());
+    CHECK(AppState::IsSendingKeys());
+    CHECK_EQ(AppState::GetActiveProfile(), 0);
+
+    uint64_t before = Utterances();
+    managers[0].HandleIncomingMessage(R"({"type":"speak","sequence":["still here"]})");
+    CHECK(WaitForUtterances(before + 1));
+    managers[2].HandleIncomingMessage(R"({"type":"speak","sequence":["me too"]})");
+    CHECK(WaitForUtterances(before + 2));
+
+    relays[0].DropAll();
+    CHECK(WaitFor([&] { return lost[0] == 1; }));
+    CHECK(!AppState::IsSendingKeys());
+    AppState::SetConnectedProfiles({}, {});
+    SpeechQueue::Shutdown();
+}
+
+TEST_CASE("ConnectionManager: a dropped connection is torn down before reconnecting") {
+    TestRelay relay;
+    ConnectionManager manager;
+    std::atomic<int> lost{0};
+    manager.SetDisconnectCallback([&lost]() { lost++; });
+    CHECK(manager.EstablishConnection("127.0.0.1", relay.Port(), "test-channel"));
+    auto client = manager.GetClient();
+    CHECK(WaitFor([&] { return client->RunningWorkers() == 2; }));
+
+    for (int drop = 1; drop <= 3; drop++) {
+        relay.DropAll();
+        CHECK(WaitFor([&] { return lost == drop; }));
+        // The reconnect thread joins the old sender and receiver and closes
+        // the old socket without waiting out the retry delay.
+        CHECK(WaitFor([&] { return client->RunningWorkers() == 0; }));
+        manager.Wake(false);
+        CHECK(WaitFor([&] { return manager.IsConnected(); }));
+        CHECK(WaitFor([&] { return client->RunningWorkers() == 2; }));
+        CHECK_EQ(relay.OpenConnections(), 1);
+        CHECK_EQ(relay.AcceptedConnections(), drop + 1);
+        CHECK_EQ(lost.load(), drop);
+    }
+}
+
+TEST_CASE("ConnectionManager: twenty sessions shut down in parallel") {
+    using Clock = std::chrono::steady_clock;
+    constexpr int SESSIONS = 20;
+    const auto deadline = std::chrono::milliseconds(Config::SHUTDOWN_DEADLINE_MS);
+    TestRelay relay;
+    relay.SetDelay(std::chrono::seconds(60));
+
+    // Torn down one at a time first, for what a serial shutdown costs: each
+    // waits for its handshake to notice the cancel.
+    auto serial = StalledSessions(relay, SESSIONS);
+    auto serialTotal = Clock::duration::zero();
+    for (auto& manager : serial) {
+        std::vector<std::unique_ptr<ConnectionManager>> one;
+        one.push_back(std::move(manager));
+        auto start = Clock::now();
+        CHECK(ConnectionManager::ShutdownAll(std::move(one), deadline));
+        serialTotal += Clock::now() - start;
+    }
+
+    auto managers = StalledSessions(relay, SESSIONS);
+    CHECK_EQ(managers.size(), static_cast<size_t>(SESSIONS));
+    auto start = Clock::now();
+    CHECK(ConnectionManager::ShutdownAll(std::move(managers), deadline));
+    auto elapsed = Clock::now() - start;
+    CHECK(elapsed < serialTotal);
+    CHECK(elapsed < std::chrono::milliseconds(1000));
+}
+
+TEST_CASE("ConnectionManager: shutdown stops waiting for stragglers at the deadline") {
+    using Clock = std::chrono::steady_clock;
+    TestRelay relay;
+    relay.SetDelay(std::chrono::seconds(60));
+    auto managers = StalledSessions(relay, 20);
+
+    auto start = Clock::now();
+    CHECK(!ConnectionManager::ShutdownAll(std::move(managers), std::chrono::milliseconds(5)));
+    CHECK(Clock::now() - start < std::chrono::milliseconds(500));
+    // The abandoned teardowns still finish, well before the relay goes.
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+}
+
+TEST_CASE("ConnectionManager: shutdown with nothing to close") {
+    std::vector<std::unique_ptr<ConnectionManager>> managers(3);
+    CHECK(ConnectionManager::ShutdownAll(std::move(managers), std::chrono::milliseconds(0)));
+}
+
+TEST_CASE("ConnectionManager: an on-demand profile waits to be woken") {
+    ProfileConfig p;
+    p.onDemand = true;
+    ConnectionManager manager;
+    manager.ApplyOnDemand(p);
+    int lost = 0;
+    manager.SetDisconnectCallback([&lost]() { lost++; });
+
+    CHECK(!manager.PrepareConnection("", 1, "test-channel"));
+    CHECK(manager.PrepareConnection("127.0.0.1", 1, "test-channel"));
+    CHECK(manager.IsHibernating());
+    CHECK(!manager.IsConnected());
+
+    manager.Wake();
+    CHECK(!manager.IsHibernating());
+    manager.Hibernate();
+    CHECK(manager.IsHibernating());
+    manager.OnConnectionLost();
+    CHECK_EQ(lost, 0);
+}
+
+TEST_CASE("ConnectionManager: an on-demand profile connects when woken and idles out") {
+    ResetRouting();
+    TestRelay relay;
+    auto p = OnDemandProfile("idle", relay.Port(), 150);
+    ConnectionManager manager;
+    manager.ApplyProfileConfig(p);
+    manager.SetProfileIndex(0);
+    CHECK(manager.PrepareConnection(p.host, p.port, p.key));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK_EQ(relay.AcceptedConnections(), 0);
+
+    manager.Wake(false);
+    CHECK(WaitFor([&] { return manager.IsConnected() && relay.JoinedConnections() == 1; }));
+
+    // Nothing is sent after the join, and no profile is selected.
+    CHECK(WaitFor([&] { return manager.IsHibernating(); }));
+    CHECK(WaitFor([&] { return relay.OpenConnections() == 0; }));
+    CHECK(!manager.IsConnected());
+    CHECK_EQ(relay.AcceptedConnections(), 1);
+
+    // The next wake resumes the session the first connection left behind.
+    manager.Wake(false);
+    CHECK(WaitFor([&] { return manager.IsConnected() && relay.JoinedConnections() == 2; }));
+    CHECK_EQ(relay.AcceptedConnections(), 2);
+    CHECK_EQ(relay.ResumedConnections(), 1);
+}
+
+TEST_CASE("ConnectionManager: selected and key-receiving profiles are never idle") {
+    ResetRouting();
+    TestRelay relay;
+    ConnectionManager selected, target;
+    auto p = OnDemandProfile("kept", relay.Port(), 100);
+    selected.ApplyProfileConfig(p);
+    target.ApplyProfileConfig(p);
+    selected.SetProfileIndex(0);
+    target.SetProfileIndex(1);
+    CHECK(selected.PrepareConnection(p.host, p.port, p.key));
+    CHECK(target.PrepareConnection(p.host, p.port, p.key));
+
+    // Profile 0 is selected; profile 1 receives keys as the broadcast group.
+    AppState::SetConnectedProfiles({0, 1}, {"selected", "target"});
+    AppState::SetBroadcastProfiles({1});
+    AppState::ToggleBroadcast();
+    CHECK_EQ(AppState::GetActiveProfile(), 0);
+    CHECK(AppState::IsReceivingKeys(1));
+    selected.Wake(false);
+    target.Wake(false);
+    CHECK(WaitFor([&] { return selected.IsConnected() && target.IsConnected(); }));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    CHECK(selected.IsConnected());
+    CHECK(target.IsConnected());
+    CHECK_EQ(relay.AcceptedConnections(), 2);
+
+    AppState::ToggleBroadcast();
+    ResetRouting();
+    CHECK(WaitFor([&] { return selected.IsHibernating() && target.IsHibernating(); }));
+    CHECK(WaitFor([&] { return relay.OpenConnections() == 0; }));
+    CHECK_EQ(relay.AcceptedConnections(), 2);
+}
+
+TEST_CASE("ConnectionManager: selecting a profile wakes it and pre-warms the next") {
+    ResetRouting();
+    TestRelay relay;
+    ConfigFileData cfg;
+    for (const char* name : {"first", "second", "third"}) {
+        cfg.profiles.push_back(OnDemandProfile(name, relay.Port(), Config::IDLE_TIMEOUT_MS));
+    }
+    CommandHandler handler("nvdaremote_on_demand_test.json", cfg);
+    AppState::SetProfileSelectedCallback([&handler](int profile, int next) { handler.WakeProfile(profile, next); });
+    handler.ConnectAutoProfiles();
+    const auto& sessions = handler.GetSessions();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK_EQ(relay.AcceptedConnections(), 0);
+
+    AppState::SetActiveProfile(1);
+    CHECK(WaitFor([&] { return sessions[1].connection->IsConnected() && sessions[2].connection->IsConnected(); }));
+    CHECK(sessions[0].connection->IsHibernating());
+    CHECK_EQ(relay.AcceptedConnections(), 2);
+    CHECK(WaitFor([&] { return relay.JoinedConnections() == 2; }));
+
+    // Cycle order wraps, so the profile after the last is the first.
+    AppState::CycleProfile();
+    CHECK_EQ(AppState::GetActiveProfile(), 2);
+    CHECK(WaitFor([&] { return sessions[0].connection->IsConnected(); }));
+    CHECK_EQ(relay.AcceptedConnections(), 3);
+
+    AppState::SetProfileSelectedCallback(nullptr);
+    CHECK(handler.Shutdown());
+    for (int i = 0; i < 3; i++) MessageSender::SetNetworkClient(i, nullptr);
+    ResetRouting();
+}
+
+#ifndef _WIN32
+TEST_CASE("ConnectionManager: clipboard text is applied up to the size cap") {
+    Clipboard::SetBackend(std::make_unique<FakeClipboardBackend>());
+    ConnectionManager manager;
+
+    manager.HandleIncomingMessage(R"({"type":"set_clipboard_text","text":"from remote é"})");
+    CHECK_EQ(Clipboard::GetText(), std::string("from remote é"));
+
+    json big = {{"type", "set_clipboard_text"}, {"text", std::string(Config::MAX_CLIPBOARD_BYTES + 1, 'x')}};
+    manager.HandleIncomingMessage(big.dump());
+    CHECK_EQ(Clipboard::GetText(), std::string("from remote é"));
+}
+#endif
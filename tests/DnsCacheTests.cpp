@@ -0,0 +1,121 @@
+#include "TestFramework.h"
+#include "DnsCache.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // Stub lookups tag their single address through its length so tests can
+    // tell which answer they were served.
+    ResolvedAddress Tagged(int tag) {
+        ResolvedAddress address;
+        address.length = tag;
+        return address;
+    }
+
+    int Lookup(const std::string& host, int port = 6837) {
+        std::vector<ResolvedAddress> out;
+        auto deadline = Clock::now() + std::chrono::seconds(1);
+        if (DnsCache::Resolve(host, port, deadline, nullptr, out) != ConnectStatus::Ok || out.empty()) return -1;
+        return out.front().length;
+    }
+
+    template <typename Predicate>
+    bool WaitFor(Predicate done) {
+        auto deadline = Clock::now() + std::chrono::seconds(2);
+        while (!done()) {
+            if (Clock::now() >= deadline) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return true;
+    }
+}
+
+TEST_CASE("DnsCache: repeat lookups are served from the cache") {
+    DnsCache::Clear();
+    std::atomic<int> calls{0};
+    TcpConnector::SetResolver([&calls](const std::string&, int, std::vector<ResolvedAddress>& out) {
+        out = {Tagged(++calls)};
+        return true;
+    });
+
+    CHECK_EQ(Lookup("relay.test"), 1);
+    CHECK_EQ(Lookup("relay.test"), 1);
+    CHECK_EQ(Lookup("relay.test"), 1);
+    CHECK_EQ(calls.load(), 1);
+    CHECK_EQ(Lookup("relay.test", 443), 2);
+
+    auto stats = DnsCache::GetStats();
+    CHECK_EQ(stats.entries, 2u);
+    CHECK_EQ(stats.hits, 2u);
+    CHECK_EQ(stats.misses, 2u);
+    CHECK(stats.hitRate > 0.49 && stats.hitRate < 0.51);
+    TcpConnector::SetResolver(nullptr);
+    DnsCache::Clear();
+}
+
+TEST_CASE("DnsCache: stale entries are served while a refresh runs") {
+    DnsCache::Clear();
+    std::atomic<int> calls{0};
+    std::atomic<bool> release{false};
+    TcpConnector::SetResolver([&](const std::string&, int, std::vector<ResolvedAddress>& out) {
+        int call = ++calls;
+        if (call > 1) {
+            while (!release) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        out = {Tagged(call)};
+        return true;
+    });
+
+    CHECK_EQ(Lookup("relay.test"), 1);
+    DnsCache::Refresh("relay.test", 6837);
+    auto start = Clock::now();
+    CHECK_EQ(Lookup("relay.test"), 1);
+    CHECK(Clock::now() - start < std::chrono::milliseconds(100));
+    CHECK(WaitFor([&calls] { return calls == 2; }));
+    CHECK_EQ(DnsCache::GetStats().staleHits, 1u);
+
+    release = true;
+    CHECK(WaitFor([] { return Lookup("relay.test") == 2; }));
+    CHECK_EQ(DnsCache::GetStats().refreshes, 1u);
+    CHECK_EQ(calls.load(), 2);
+    TcpConnector::SetResolver(nullptr);
+    DnsCache::Clear();
+}
+
+TEST_CASE("DnsCache: a failed refresh keeps the stale addresses") {
+    DnsCache::Clear();
+    std::atomic<int> calls{0};
+    TcpConnector::SetResolver([&calls](const std::string&, int, std::vector<ResolvedAddress>& out) {
+        if (++calls > 1) return false;
+        out = {Tagged(7)};
+        return true;
+    });
+
+    CHECK_EQ(Lookup("relay.test"), 7);
+    DnsCache::Refresh("relay.test", 6837);
+    CHECK(WaitFor([] { return DnsCache::GetStats().refreshFailures == 1; }));
+    CHECK_EQ(Lookup("relay.test"), 7);
+    CHECK(WaitFor([&calls] { return calls == 3; }));
+    CHECK(WaitFor([] { return DnsCache::GetStats().refreshFailures == 2; }));
+    TcpConnector::SetResolver(nullptr);
+    DnsCache::Clear();
+}
+
+TEST_CASE("DnsCache: failed lookups are not cached") {
+    DnsCache::Clear();
+    std::atomic<int> calls{0};
+    TcpConnector::SetResolver([&calls](const std::string&, int, std::vector<ResolvedAddress>& out) {
+        if (++calls == 1) return false;
+        out = {Tagged(3)};
+        return true;
+    });
+
+    CHECK_EQ(Lookup("relay.test"), -1);
+    CHECK_EQ(Lookup("relay.test"), 3);
+    CHECK_EQ(DnsCache::GetStats().misses, 2u);
+    TcpConnector::SetResolver(nullptr);
+    DnsCache::Clear();
+}
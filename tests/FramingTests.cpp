@@ -0,0 +1,54 @@
+#include "TestFramework.h"
+#include "NetworkClient.h"
+#include "ReceiveFramer.h"
+#include <string>
+#include <vector>
+
+namespace {
+    std::vector<std::string> FeedInChunks(ReceiveFramer& framer, const std::string& stream, size_t chunk) {
+        std::vector<std::string> lines;
+        for (size_t pos = 0; pos < stream.size(); pos += chunk) {
+            framer.Feed(stream.data() + pos, std::min(chunk, stream.size() - pos),
+                        [&](std::string_view line) { lines.emplace_back(line); });
+        }
+        return lines;
+    }
+}
+
+TEST_CASE("Framing: outgoing messages end in exactly one newline") {
+    auto framed = NetworkClient::FrameMessage(R"({"type":"cancel"})");
+    CHECK_EQ(*framed, std::string("{\"type\":\"cancel\"}\n"));
+}
+
+TEST_CASE("Framing: splits lines regardless of chunk size") {
+    const std::string stream = "{\"a\":1}\r\n{\"b\":2}\n\n{\"c\":3}\n{\"partial";
+    for (size_t chunk = 1; chunk <= stream.size(); chunk++) {
+        ReceiveFramer framer(64);
+        auto lines = FeedInChunks(framer, stream, chunk);
+        CHECK_EQ(lines.size(), 3u);
+        CHECK_EQ(lines[0], std::string("{\"a\":1}"));
+        CHECK_EQ(lines[2], std::string("{\"c\":3}"));
+        CHECK_EQ(framer.Buffered(), std::string("{\"partial").size());
+    }
+}
+
+TEST_CASE("Framing: oversize line is dropped and the stream resynchronises") {
+    const std::string stream = "short\n" + std::string(100, 'x') + "\nafter\n";
+    for (size_t chunk : {1u, 7u, 40u, 200u}) {
+        ReceiveFramer framer(16);
+        auto lines = FeedInChunks(framer, stream, chunk);
+        CHECK_EQ(lines.size(), 2u);
+        CHECK_EQ(lines[0], std::string("short"));
+        CHECK_EQ(lines[1], std::string("after"));
+        CHECK_EQ(framer.Discarded(), 1u);
+        CHECK_EQ(framer.Buffered(), 0u);
+    }
+}
+
+TEST_CASE("Framing: a line exactly at the limit is kept") {
+    ReceiveFramer framer(8);
+    auto lines = FeedInChunks(framer, "12345678\n123456789\n", 3);
+    CHECK_EQ(lines.size(), 1u);
+    CHECK_EQ(lines[0], std::string("12345678"));
+    CHECK_EQ(framer.Discarded(), 1u);
+}
@@ -0,0 +1,107 @@
+#include "TestFramework.h"
+#include "KeyboardState.h"
+
+namespace {
+    void ResetKeyboard() {
+        KeyboardState::ClearShortcuts();
+        KeyboardState::SetCycleShortcut("");
+        KeyboardState::SetForwardKeysShortcut("");
+        KeyboardState::SetBroadcastShortcut("");
+        KeyboardState::ResetModifiers();
+        KeyboardState::ClearPressedKeys();
+    }
+
+    void Press(NativeKeyType vk) { KeyboardState::UpdateModifierState(vk, true); }
+    void Release(NativeKeyType vk) { KeyboardState::UpdateModifierState(vk, false); }
+}
+
+TEST_CASE("KeyboardState: parses modifiers and key") {
+    ShortcutConfig sc = KeyboardState::ParseShortcutString("ctrl+shift+f11");
+    CHECK(sc.ctrl);
+    CHECK(sc.shift);
+    CHECK(!sc.alt);
+    CHECK(!sc.win);
+    CHECK_EQ(sc.key, VK_F11);
+}
+
+TEST_CASE("KeyboardState: parsing ignores case and spaces") {
+    ShortcutConfig sc = KeyboardState::ParseShortcutString(" Control + ALT + PgDn ");
+    CHECK(sc.ctrl);
+    CHECK(sc.alt);
+    CHECK_EQ(sc.key, VK_NEXT);
+}
+
+TEST_CASE("KeyboardState: letters, digits and modifier aliases") {
+    CHECK_EQ(KeyboardState::ParseShortcutString("win+a").key, static_cast<NativeKeyType>('A'));
+    CHECK(KeyboardState::ParseShortcutString("cmd+7").win);
+    CHECK_EQ(KeyboardState::ParseShortcutString("windows+7").key, static_cast<NativeKeyType>('7'));
+}
+
+TEST_CASE("KeyboardState: unknown keys and empty strings leave the key unset") {
+    CHECK_EQ(KeyboardState::ParseShortcutString("").key, 0u);
+    CHECK_EQ(KeyboardState::ParseShortcutString("ctrl+nosuchkey").key, 0u);
+    CHECK_EQ(KeyboardState::ParseShortcutString("ctrl+f25").key, 0u);
+    CHECK_EQ(KeyboardState::ParseShortcutString("ctrl+f").key, static_cast<NativeKeyType>('F'));
+}
+
+TEST_CASE("KeyboardState: shortcut matches only with exact modifiers") {
+    ResetKeyboard();
+    KeyboardState::SetCycleShortcut("ctrl+shift+f11");
+
+    CHECK(!KeyboardState::CheckCycleShortcut(VK_F11));
+    Press(VK_LCONTROL);
+    CHECK(!KeyboardState::CheckCycleShortcut(VK_F11));
+    Press(VK_RSHIFT);
+    CHECK(KeyboardState::CheckCycleShortcut(VK_F11));
+    Press(VK_LMENU);
+    CHECK(!KeyboardState::CheckCycleShortcut(VK_F11));
+    Release(VK_LMENU);
+    CHECK(KeyboardState::CheckCycleShortcut(VK_F11));
+    CHECK(!KeyboardState::CheckCycleShortcut(VK_F12));
+    ResetKeyboard();
+}
+
+TEST_CASE("KeyboardState: profile toggles carry their index") {
+    ResetKeyboard();
+    KeyboardState::SetToggleShortcutAt(2, "alt+3");
+    Press(VK_MENU);
+    CHECK_EQ(KeyboardState::CheckToggleShortcut('3'), 2);
+    CHECK_EQ(KeyboardState::CheckToggleShortcut('4'), -1);
+    ResetKeyboard();
+}
+
+TEST_CASE("KeyboardState: earlier binding wins a collision") {
+    ResetKeyboard();
+    KeyboardState::SetForwardKeysShortcut("ctrl+f12");
+    KeyboardState::SetCycleShortcut("ctrl+f12");
+    Press(VK_CONTROL);
+    auto binding = KeyboardState::LookupShortcut(VK_F12);
+    CHECK(binding.action == ShortcutAction::ForwardKeys);
+    ResetKeyboard();
+}
+
+TEST_CASE("KeyboardState: pressed keys are tracked once and released") {
+    ResetKeyboard();
+    KeyboardState::TrackKeyPress('A', 30, false);
+    KeyboardState::TrackKeyPress('A', 30, false);
+    KeyboardState::TrackKeyPress(VK_INSERT, 82, true);
+    CHECK_EQ(KeyboardState::GetAllPressedKeys().size(), 2u);
+    CHECK(KeyboardState::GetAllPressedKeys()[1].extended);
+
+    CHECK(KeyboardState::TrackKeyRelease('A'));
+    CHECK(!KeyboardState::TrackKeyRelease('A'));
+    CHECK_EQ(KeyboardState::GetAllPressedKeys().size(), 1u);
+    KeyboardState::ClearPressedKeys();
+    CHECK(KeyboardState::GetAllPressedKeys().empty());
+}
+
+TEST_CASE("KeyboardState: taking pressed keys empties the list") {
+    ResetKeyboard();
+    KeyboardState::TrackKeyPress('A', 30, false);
+    KeyboardState::TrackKeyPress('B', 48, false);
+    auto taken = KeyboardState::TakeAllPressedKeys();
+    CHECK_EQ(taken.size(), 2u);
+    CHECK_EQ(taken[0].vkCode, static_cast<uint32_t>('A'));
+    CHECK(KeyboardState::GetAllPressedKeys().empty());
+    CHECK(!KeyboardState::TrackKeyRelease('A'));
+}
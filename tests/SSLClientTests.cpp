@@ -0,0 +1,84 @@
+#include "TestFramework.h"
+#include "SSLClient.h"
+#include "TestRelay.h"
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    // Numbered lines, so the relay's line count shows nothing was lost or
+    // split wrongly.
+    std::string Lines(size_t count, size_t width) {
+        std::string text;
+        text.reserve(count * (width + 1));
+        for (size_t i = 0; i < count; i++) {
+            std::string line = std::to_string(i);
+            line.resize(width, 'x');
+            text += line;
+            text += '\n';
+        }
+        return text;
+    }
+}
+
+TEST_CASE("SSLClient: SendAll gets everything through a throttled reader") {
+    TestRelay relay;
+    relay.SetReadLimit(64 * 1024);
+    SSLClient client;
+    CHECK(client.Connect("127.0.0.1", relay.Port()));
+
+    // Several times what loopback socket buffers hold, so writes stall on
+    // WANT_WRITE and resume in pieces.
+    const std::string payload = Lines(64 * 1024, 127);
+    int sent = client.SendAll(payload.data(), static_cast<int>(payload.size()), [] { return true; });
+    CHECK_EQ(sent, static_cast<int>(payload.size()));
+    CHECK(WaitFor([&] { return relay.BytesReceived() == payload.size(); }, std::chrono::seconds(10)));
+    CHECK_EQ(relay.LinesReceived(), 64u * 1024u);
+    CHECK(client.IsConnected());
+}
+
+TEST_CASE("SSLClient: many writers share a throttled relay") {
+    constexpr int CLIENTS = 8;
+    TestRelay relay;
+    relay.SetReadLimit(16 * 1024);
+    const std::string payload = Lines(4096, 255);
+
+    std::vector<std::thread> writers;
+    std::atomic<int> complete{0};
+    for (int i = 0; i < CLIENTS; i++) {
+        writers.emplace_back([&] {
+            SSLClient client;
+            if (!client.Connect("127.0.0.1", relay.Port())) return;
+            int sent = client.SendAll(payload.data(), static_cast<int>(payload.size()), [] { return true; });
+            if (sent == static_cast<int>(payload.size())) complete++;
+            // Stay connected until the relay has read everything, so closing
+            // does not discard what is still buffered.
+            WaitFor([&] { return relay.BytesReceived() >= CLIENTS * payload.size(); }, std::chrono::seconds(20));
+        });
+    }
+    for (auto& writer : writers) writer.join();
+    CHECK_EQ(complete.load(), CLIENTS);
+    CHECK_EQ(relay.BytesReceived(), CLIENTS * payload.size());
+    CHECK_EQ(relay.LinesReceived(), CLIENTS * 4096u);
+}
+
+TEST_CASE("SSLClient: SendAll gives up once the connection is abandoned") {
+    TestRelay relay;
+    relay.SetReadLimit(1);
+    SSLClient client;
+    CHECK(client.Connect("127.0.0.1", relay.Port()));
+
+    const std::string payload = Lines(64 * 1024, 127);
+    auto start = std::chrono::steady_clock::now();
+    std::atomic<bool> keepWaiting{true};
+    std::thread stopper([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        keepWaiting = false;
+    });
+    int sent = client.SendAll(payload.data(), static_cast<int>(payload.size()), [&] { return keepWaiting.load(); });
+    stopper.join();
+    CHECK_EQ(sent, -1);
+    CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(2));
+}
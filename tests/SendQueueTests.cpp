@@ -0,0 +1,154 @@
+#include "TestFramework.h"
+#include "SendQueue.h"
+#include <string>
+
+namespace {
+    std::shared_ptr<const std::string> Msg(const std::string& text) {
+        return std::make_shared<const std::string>(text);
+    }
+
+    void OpenWithLimits(SendQueue& queue, size_t maxMessages, size_t maxBytes = Config::SEND_QUEUE_MAX_BYTES) {
+        SendQueueLimits limits;
+        limits.maxMessages = maxMessages;
+        limits.maxBytes = maxBytes;
+        queue.SetLimits(limits);
+        queue.Open();
+    }
+
+    std::string Pop(SendQueue& queue) {
+        std::shared_ptr<const std::string> out;
+        return queue.WaitPop(out) ? *out : std::string();
+    }
+}
+
+TEST_CASE("SendQueue: delivers in order") {
+    SendQueue queue;
+    queue.Open();
+    CHECK(queue.Push(Msg("a"), SendKind::Control));
+    CHECK(queue.Push(Msg("b"), SendKind::KeyPress, 'A'));
+    CHECK(queue.Push(Msg("c"), SendKind::KeyRelease, 'A'));
+    CHECK_EQ(Pop(queue), std::string("a"));
+    CHECK_EQ(Pop(queue), std::string("b"));
+    CHECK_EQ(Pop(queue), std::string("c"));
+    CHECK_EQ(queue.GetStats().depth, 0u);
+}
+
+TEST_CASE("SendQueue: refuses when closed") {
+    SendQueue queue;
+    CHECK(!queue.Push(Msg("a"), SendKind::Control));
+    queue.Open();
+    queue.Close();
+    std::shared_ptr<const std::string> out;
+    CHECK(!queue.WaitPop(out));
+}
+
+TEST_CASE("SendQueue: repeats are evicted to make room") {
+    SendQueue queue;
+    OpenWithLimits(queue, 4);
+    CHECK(queue.Push(Msg("down"), SendKind::KeyPress, 'A'));
+    CHECK(queue.Push(Msg("repeat1"), SendKind::KeyPress, 'A'));
+    CHECK(queue.Push(Msg("repeat2"), SendKind::KeyPress, 'A'));
+    CHECK(queue.Push(Msg("repeat3"), SendKind::KeyPress, 'A'));
+    CHECK(queue.Push(Msg("ctl"), SendKind::Control));
+    CHECK(queue.GetStats().dropped > 0);
+    CHECK_EQ(Pop(queue), std::string("down"));
+}
+
+TEST_CASE("SendQueue: release of a refused press is dropped too") {
+    SendQueue queue;
+    OpenWithLimits(queue, 2);
+    CHECK(queue.Push(Msg("c1"), SendKind::Control));
+    CHECK(queue.Push(Msg("c2"), SendKind::Control));
+    CHECK(!queue.Push(Msg("down"), SendKind::KeyPress, 'B'));
+    CHECK(!queue.Push(Msg("up"), SendKind::KeyRelease, 'B'));
+    CHECK_EQ(queue.GetStats().refused, 1u);
+}
+
+TEST_CASE("SendQueue: release of a sent press is always accepted") {
+    SendQueue queue;
+    OpenWithLimits(queue, 2);
+    CHECK(queue.Push(Msg("down"), SendKind::KeyPress, 'C'));
+    CHECK_EQ(Pop(queue), std::string("down"));
+    CHECK(queue.Push(Msg("c1"), SendKind::Control));
+    CHECK(queue.Push(Msg("c2"), SendKind::Control));
+    CHECK(queue.Push(Msg("up"), SendKind::KeyRelease, 'C'));
+}
+
+TEST_CASE("SendQueue: a release collapses only the last queued key") {
+    SendQueue queue;
+    OpenWithLimits(queue, 4);
+    CHECK(queue.Push(Msg("c1"), SendKind::Control));
+    CHECK(queue.Push(Msg("c2"), SendKind::Control));
+    CHECK(queue.Push(Msg("a down"), SendKind::KeyPress, 'A'));
+    CHECK(queue.Push(Msg("a up"), SendKind::KeyRelease, 'A'));
+    CHECK_EQ(queue.GetStats().collapsed, 1u);
+    CHECK_EQ(queue.GetStats().depth, 2u);
+}
+
+TEST_CASE("SendQueue: a chord is not collapsed into a bare key") {
+    SendQueue queue;
+    OpenWithLimits(queue, 6);
+    const uint32_t ctrl = 0xA2;
+    CHECK(queue.Push(Msg("c1"), SendKind::Control));
+    CHECK(queue.Push(Msg("c2"), SendKind::Control));
+    CHECK(queue.Push(Msg("ctrl down"), SendKind::KeyPress, ctrl));
+    CHECK(queue.Push(Msg("w down"), SendKind::KeyPress, 'W'));
+    CHECK(queue.Push(Msg("w up"), SendKind::KeyRelease, 'W'));
+    CHECK(queue.Push(Msg("ctrl up"), SendKind::KeyRelease, ctrl));
+    // W's press was the last key event, so W is cancelled, and then Ctrl's
+    // press is. Nothing ever reaches the remote as a bare w.
+    CHECK_EQ(queue.GetStats().collapsed, 2u);
+    CHECK_EQ(Pop(queue), std::string("c1"));
+    CHECK_EQ(Pop(queue), std::string("c2"));
+    CHECK_EQ(queue.GetStats().depth, 0u);
+
+    CHECK(queue.Push(Msg("c3"), SendKind::Control));
+    CHECK(queue.Push(Msg("c4"), SendKind::Control));
+    CHECK(queue.Push(Msg("ctrl down"), SendKind::KeyPress, ctrl));
+    CHECK(queue.Push(Msg("w down"), SendKind::KeyPress, 'W'));
+    CHECK(queue.Push(Msg("ctrl up"), SendKind::KeyRelease, ctrl));
+    CHECK(queue.Push(Msg("w up"), SendKind::KeyRelease, 'W'));
+    CHECK_EQ(queue.GetStats().collapsed, 2u);
+    CHECK_EQ(Pop(queue), std::string("c3"));
+    CHECK_EQ(Pop(queue), std::string("c4"));
+    CHECK_EQ(Pop(queue), std::string("ctrl down"));
+    CHECK_EQ(Pop(queue), std::string("w down"));
+    CHECK_EQ(Pop(queue), std::string("ctrl up"));
+    CHECK_EQ(Pop(queue), std::string("w up"));
+}
+
+TEST_CASE("SendQueue: releases of untracked codes respect the limit") {
+    SendQueue queue;
+    OpenWithLimits(queue, 4);
+    int accepted = 0;
+    for (uint32_t vk = 256; vk < 300; vk++) {
+        if (queue.Push(Msg("up"), SendKind::KeyRelease, vk)) accepted++;
+    }
+    CHECK_EQ(accepted, 4);
+    CHECK_EQ(queue.GetStats().depth, 4u);
+    CHECK_EQ(queue.GetStats().refused, 40u);
+}
+
+TEST_CASE("SendQueue: clipboard over the byte limit is refused") {
+    SendQueue queue;
+    OpenWithLimits(queue, 16, 32);
+    CHECK(!queue.Push(Msg(std::string(64, 'x')), SendKind::Clipboard));
+    CHECK(queue.Push(Msg(std::string(16, 'x')), SendKind::Clipboard));
+}
+
+TEST_CASE("SendQueue: progress callback travels with its message") {
+    SendQueue queue;
+    queue.Open();
+    size_t reported = 0;
+    CHECK(queue.Push(Msg("plain"), SendKind::Control));
+    CHECK(queue.Push(Msg("clip"), SendKind::Clipboard, 0, [&](size_t sent, size_t) { reported = sent; }));
+
+    std::shared_ptr<const std::string> out;
+    SendProgress progress;
+    CHECK(queue.WaitPop(out, &progress));
+    CHECK(!progress);
+    CHECK(queue.WaitPop(out, &progress));
+    CHECK(static_cast<bool>(progress));
+    progress(4, 4);
+    CHECK_EQ(reported, 4u);
+}
@@ -0,0 +1,190 @@
+#include "TestFramework.h"
+#include "SpeechQueue.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Speech is not initialised, so the worker's calls into the backend return
+// at once. Stats are process-wide, so each test compares against its start.
+namespace {
+    // Every Enqueue either adds an utterance or merges into the last one, and
+    // every utterance is either spoken or cancelled.
+    uint64_t Accounted(const SpeechQueueStats& stats) {
+        return stats.spoken + stats.merged + stats.cancelled + stats.depth;
+    }
+
+    bool WaitForIdle() {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (SpeechQueue::GetStats().depth != 0) {
+            if (std::chrono::steady_clock::now() > deadline) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    // Stands in for the speech backend and keeps what reaches it: spoken
+    // text, with a leading '!' when it interrupts, and "<stop>" for stops.
+    class RecordingBackend {
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        std::vector<std::string> m_calls;
+        bool m_holding = false;
+        bool m_held = false;
+
+        void Record(std::string call) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_calls.push_back(std::move(call));
+            m_held = m_holding;
+            m_cv.notify_all();
+            m_cv.wait(lock, [this] { return !m_holding; });
+            m_held = false;
+        }
+
+    public:
+        RecordingBackend() {
+            SpeechQueue::SetBackend(
+                [this](std::string_view text, bool interrupt) { Record((interrupt ? "!" : "") + std::string(text)); },
+                [this]() { Record("<stop>"); });
+        }
+        ~RecordingBackend() { SpeechQueue::SetBackend(nullptr, nullptr); }
+
+        // Makes the next call wait, and the worker with it, until Release.
+        void Hold() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_holding = true;
+        }
+        bool WaitUntilHeld() {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            return m_cv.wait_for(lock, std::chrono::seconds(2), [this] { return m_held; });
+        }
+        void Release() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_holding = false;
+            m_cv.notify_all();
+        }
+        bool WaitForCalls(size_t count) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            return m_cv.wait_for(lock, std::chrono::seconds(2), [&] { return m_calls.size() >= count; });
+        }
+        std::vector<std::string> Calls() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_calls;
+        }
+    };
+}
+
+TEST_CASE("SpeechQueue: every utterance is spoken or merged") {
+    SpeechQueue::Start();
+    auto before = SpeechQueue::GetStats();
+    for (int i = 0; i < 1000; i++) SpeechQueue::Enqueue("line " + std::to_string(i));
+    CHECK(WaitForIdle());
+
+    auto after = SpeechQueue::GetStats();
+    CHECK_EQ(Accounted(after) - Accounted(before), 1000u);
+    CHECK_EQ(after.cancelled, before.cancelled);
+    CHECK(after.peakDepth >= 1);
+    CHECK(after.maxLatencyMs >= after.lastLatencyMs);
+    SpeechQueue::Shutdown();
+}
+
+TEST_CASE("SpeechQueue: an interrupting utterance cancels what is waiting") {
+    SpeechQueue::Start();
+    auto before = SpeechQueue::GetStats();
+    for (int i = 0; i < 200; i++) {
+        SpeechQueue::Enqueue("queued " + std::to_string(i));
+        if (i % 50 == 49) SpeechQueue::Enqueue("interrupt", true);
+    }
+    SpeechQueue::Cancel();
+    CHECK(WaitForIdle());
+
+    auto after = SpeechQueue::GetStats();
+    CHECK_EQ(Accounted(after) - Accounted(before), 204u);
+    SpeechQueue::Shutdown();
+}
+
+TEST_CASE("SpeechQueue: empty text and a stopped queue are ignored") {
+    SpeechQueue::Start();
+    auto before = SpeechQueue::GetStats();
+    SpeechQueue::Enqueue("");
+    SpeechQueue::Enqueue(std::string_view());
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    CHECK_EQ(Accounted(SpeechQueue::GetStats()), Accounted(before));
+    SpeechQueue::Shutdown();
+
+    // Stopped, Enqueue and Cancel go straight to the backend.
+    before = SpeechQueue::GetStats();
+    SpeechQueue::Enqueue("direct");
+    SpeechQueue::Cancel();
+    CHECK_EQ(Accounted(SpeechQueue::GetStats()), Accounted(before));
+}
+
+TEST_CASE("SpeechQueue: waiting utterances are merged in order") {
+    RecordingBackend backend;
+    SpeechQueue::Start();
+    backend.Hold();
+    SpeechQueue::Enqueue("first");
+    CHECK(backend.WaitUntilHeld());
+    SpeechQueue::Enqueue("one");
+    SpeechQueue::Enqueue("two");
+    SpeechQueue::Enqueue("three");
+    backend.Release();
+    CHECK(backend.WaitForCalls(2));
+    CHECK(WaitForIdle());
+    SpeechQueue::Shutdown();
+
+    auto calls = backend.Calls();
+    CHECK_EQ(calls.size(), 2u);
+    CHECK_EQ(calls[0], "first");
+    CHECK_EQ(calls[1], "one two three");
+}
+
+TEST_CASE("SpeechQueue: cancelled text is never spoken") {
+    RecordingBackend backend;
+    SpeechQueue::Start();
+
+    // An interrupting utterance drops what is waiting and starts a new one,
+    // which later text is merged into.
+    backend.Hold();
+    SpeechQueue::Enqueue("first");
+    CHECK(backend.WaitUntilHeld());
+    SpeechQueue::Enqueue("dropped");
+    SpeechQueue::Enqueue("also dropped");
+    SpeechQueue::Enqueue("urgent", true);
+    SpeechQueue::Enqueue("after");
+    backend.Release();
+    CHECK(backend.WaitForCalls(2));
+
+    // Cancel drops what is waiting and stops the backend.
+    backend.Hold();
+    SpeechQueue::Enqueue("second");
+    CHECK(backend.WaitUntilHeld());
+    SpeechQueue::Enqueue("never");
+    SpeechQueue::Cancel();
+    backend.Release();
+    CHECK(backend.WaitForCalls(4));
+    CHECK(WaitForIdle());
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    SpeechQueue::Shutdown();
+
+    auto calls = backend.Calls();
+    CHECK_EQ(calls.size(), 4u);
+    CHECK_EQ(calls[0], "first");
+    CHECK_EQ(calls[1], "!urgent after");
+    CHECK_EQ(calls[2], "second");
+    CHECK_EQ(calls[3], "<stop>");
+}
+
+TEST_CASE("SpeechQueue: a stopped queue speaks and stops directly") {
+    RecordingBackend backend;
+    SpeechQueue::Enqueue("direct", true);
+    SpeechQueue::Cancel();
+    auto calls = backend.Calls();
+    CHECK_EQ(calls.size(), 2u);
+    CHECK_EQ(calls[0], "!direct");
+    CHECK_EQ(calls[1], "<stop>");
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Minimal self-registering test harness. Each TEST_CASE is named
+// "<Suite>: <description>" so CTest can run one suite per entry by
+// passing the suite name as a filter.
+namespace Test {
+    struct Case {
+        const char* name;
+        std::function<void()> body;
+    };
+
+    struct Failure {
+        std::string message;
+    };
+
+    inline std::vector<Case>& Registry() {
+        static std::vector<Case> cases;
+        return cases;
+    }
+
+    struct Registrar {
+        Registrar(const char* name, std::function<void()> body) {
+            Registry().push_back({name, std::move(body)});
+        }
+    };
+
+    [[noreturn]] inline void Fail(const char* file, int line, const std::string& message) {
+        std::ostringstream out;
+        out << file << ":" << line << ": " << message;
+        throw Failure{out.str()};
+    }
+}
+
+#define TEST_CONCAT_IMPL(a, b) a##b
+#define TEST_CONCAT(a, b) TEST_CONCAT_IMPL(a, b)
+
+#define TEST_CASE(name)                                                                    \
+    static void TEST_CONCAT(TestBody_, __LINE__)();                                        \
+    static Test::Registrar TEST_CONCAT(TestRegistrar_, __LINE__)(name, TEST_CONCAT(TestBody_, __LINE__)); \
+    static void TEST_CONCAT(TestBody_, __LINE__)()
+
+#define CHECK(cond)                                                                        \
+    do {                                                                                   \
+        if (!(cond)) Test::Fail(__FILE__, __LINE__, "CHECK(" #cond ")");                   \
+    } while (0)
+
+#define CHECK_EQ(actual, expected)                                                         \
+    do {                                                                                   \
+        const auto& checkActual_ = (actual);                                               \
+        const auto& checkExpected_ = (expected);                                           \
+        if (!(checkActual_ == checkExpected_)) {                                           \
+            std::ostringstream checkOut_;                                                  \
+            checkOut_ << "CHECK_EQ(" #actual ", " #expected "): got " << checkActual_      \
+                      << ", expected " << checkExpected_;                                  \
+            Test::Fail(__FILE__, __LINE__, checkOut_.str());                               \
+        }                                                                                  \
+    } while (0)
@@ -0,0 +1,42 @@
+#include "TestFramework.h"
+#include <atomic>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+std::atomic<bool> g_shutdown{false};
+#ifdef _WIN32
+DWORD g_mainThreadId = 0;
+#endif
+
+// Usage: nvdaremote_tests [filter]. Runs every case whose name starts with
+// the filter, or all cases when none is given.
+int main(int argc, char** argv) {
+    const char* filter = argc > 1 ? argv[1] : "";
+    int passed = 0;
+    int failed = 0;
+
+    for (const auto& test : Test::Registry()) {
+        if (std::strncmp(test.name, filter, std::strlen(filter)) != 0) continue;
+        try {
+            test.body();
+            passed++;
+        } catch (const Test::Failure& f) {
+            std::cout << "FAIL " << test.name << "\n  " << f.message << std::endl;
+            failed++;
+        } catch (const std::exception& e) {
+            std::cout << "FAIL " << test.name << "\n  unexpected exception: " << e.what() << std::endl;
+            failed++;
+        }
+    }
+
+    std::cout << passed << " passed, " << failed << " failed" << std::endl;
+    if (passed + failed == 0) {
+        std::cout << "No tests match '" << filter << "'" << std::endl;
+        return 1;
+    }
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,127 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/net_sockets.h>
+#include <mbedtls/pk.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/ssl_ticket.h>
+#include <mbedtls/x509_crt.h>
+
+// A loopback NVDA Remote relay for tests and benchmarks. One thread serves
+// every connection over real TLS with a built-in self-signed certificate,
+// which the client accepts since it does not verify the server. Each join
+// is answered with channel_joined; everything else is counted and dropped.
+class TestRelay {
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // Bytes held back until their due time, for SetDelay.
+    struct Delayed {
+        Clock::time_point due;
+        std::string data;
+    };
+
+    struct Connection {
+        mbedtls_net_context net;
+        mbedtls_ssl_context ssl;
+        bool handshaken = false;
+        std::string in;
+        std::string out;
+        std::chrono::milliseconds delay{0};
+        std::deque<Delayed> inbound;
+        std::deque<Delayed> outbound;
+        bool peerClosed = false;
+    };
+
+    mbedtls_entropy_context m_entropy;
+    mbedtls_ctr_drbg_context m_ctrDrbg;
+    mbedtls_x509_crt m_cert;
+    mbedtls_pk_context m_key;
+    mbedtls_ssl_config m_config;
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    mbedtls_ssl_ticket_context m_tickets;
+#endif
+    mbedtls_net_context m_listen;
+    int m_port = 0;
+
+    std::vector<std::unique_ptr<Connection>> m_connections;
+    std::thread m_thread;
+    std::atomic<bool> m_stop{false};
+    std::atomic<int> m_open{0};
+    std::atomic<int> m_accepted{0};
+    std::atomic<int> m_joined{0};
+    std::atomic<int> m_resumed{0};
+    std::atomic<uint64_t> m_bytes{0};
+    std::atomic<uint64_t> m_lines{0};
+    std::atomic<size_t> m_readLimit{0};
+    std::atomic<int> m_delayMs{0};
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    uint64_t m_dropRequested = 0;
+    uint64_t m_dropHandled = 0;
+
+    bool Setup();
+    void Run();
+    void Accept();
+    bool Service(Connection& connection);
+    bool Flush(Connection& connection);
+    void Feed(Connection& connection, const unsigned char* data, size_t length);
+    static int DelayedSend(void* context, const unsigned char* data, size_t length);
+    static int DelayedRecv(void* context, unsigned char* data, size_t length);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    static int WriteTicket(void* context, const mbedtls_ssl_session* session, unsigned char* start,
+                           const unsigned char* end, size_t* length, uint32_t* lifetime);
+    static int ParseTicket(void* context, mbedtls_ssl_session* session, unsigned char* ticket, size_t length);
+#endif
+    void Close(Connection& connection);
+    void CloseAll();
+
+public:
+    TestRelay();
+    ~TestRelay();
+    TestRelay(const TestRelay&) = delete;
+    TestRelay& operator=(const TestRelay&) = delete;
+
+    // 0 if the relay could not be started.
+    int Port() const { return m_port; }
+    int OpenConnections() const { return m_open; }
+    int AcceptedConnections() const { return m_accepted; }
+    int JoinedConnections() const { return m_joined; }
+    // Handshakes that resumed a session from one of this relay's tickets.
+    int ResumedConnections() const { return m_resumed; }
+    uint64_t BytesReceived() const { return m_bytes; }
+    uint64_t LinesReceived() const { return m_lines; }
+
+    // Closes every open connection, like a relay restart, and returns once
+    // they are closed.
+    void DropAll();
+    // Reads at most this many bytes per connection every few milliseconds,
+    // like a slow link. 0 removes the limit.
+    void SetReadLimit(size_t bytesPerPass) { m_readLimit = bytesPerPass; }
+    // Holds everything each way for this long before passing it on, so a
+    // round trip takes twice the delay. Applies to connections accepted
+    // after the call.
+    void SetDelay(std::chrono::milliseconds oneWay) { m_delayMs = static_cast<int>(oneWay.count()); }
+};
+
+// Polls condition until it holds or timeout passes.
+template<typename Condition>
+bool WaitFor(Condition condition, std::chrono::milliseconds timeout = std::chrono::seconds(5)) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
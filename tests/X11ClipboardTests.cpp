@@ -0,0 +1,60 @@
+#include "TestFramework.h"
+#include "ClipboardBackend.h"
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+// The owner and the reader are separate X connections, so every read goes
+// through the server the way another application's would. Without a
+// display the tests pass without running; CTest runs them under xvfb-run
+// when it is installed.
+namespace {
+    bool HaveDisplay() {
+        if (std::getenv("DISPLAY")) return true;
+        std::cout << "X11Clipboard: skipped, DISPLAY is not set" << std::endl;
+        return false;
+    }
+
+    std::string Payload(size_t size) {
+        std::string text;
+        text.reserve(size);
+        for (size_t i = 0; i < size; i++) text.push_back(static_cast<char>('a' + (i * 7 + i / 26) % 26));
+        return text;
+    }
+}
+
+TEST_CASE("X11Clipboard: a small payload round-trips through the server") {
+    if (!HaveDisplay()) return;
+    auto owner = CreateX11ClipboardBackend();
+    auto reader = CreateX11ClipboardBackend();
+    CHECK(owner != nullptr);
+    CHECK(reader != nullptr);
+
+    std::string text = "from remote \xc3\xa9 \xe2\x9c\x93";
+    CHECK(owner->SetText(text));
+    std::string out;
+    CHECK(reader->GetText(out));
+    CHECK_EQ(out, text);
+
+    // Taking the selection back the other way.
+    CHECK(reader->SetText("reply"));
+    CHECK(owner->GetText(out));
+    CHECK_EQ(out, std::string("reply"));
+}
+
+TEST_CASE("X11Clipboard: a payload above the INCR threshold round-trips") {
+    if (!HaveDisplay()) return;
+    auto owner = CreateX11ClipboardBackend();
+    auto reader = CreateX11ClipboardBackend();
+    CHECK(owner != nullptr);
+    CHECK(reader != nullptr);
+
+    // The owner writes at most 256 KiB per property change, so this takes
+    // an INCR transfer of several chunks.
+    std::string text = Payload(1024 * 1024 + 17);
+    CHECK(owner->SetText(text));
+    std::string out;
+    CHECK(reader->GetText(out));
+    CHECK_EQ(out.size(), text.size());
+    CHECK(out == text);
+}